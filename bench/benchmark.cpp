@@ -0,0 +1,336 @@
+#include "epwGenerator.h"
+#include "../src/EPWConverter.h"
+#include "../src/EPWTokenizer.h"
+#include "../src/utils.h"
+#include "../src/psychrometrics.h"
+#include "../src/wthWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// benchmarks of the converter on synthetic epw files
+// each case is run until it has taken at least the minimum time and the rate of the fastest run
+// is reported in rows (lines or values) per second and in MB of epw text per second
+//
+// build on Linux from the root of the repository with make, which writes build/epwBenchmark
+//
+// epwBenchmark [--quick] [--filter <Text>] [--generate <Directory>]
+//   --quick runs each case for a shorter time and leaves out the largest file
+//   --filter runs only the cases whose names contain the text
+//   --generate writes the synthetic epw files to a directory (for timing the CLI) instead of running
+
+// a stream buffer that throws away what is written to it
+class nullStreambuf : public std::streambuf
+{
+protected:
+  int overflow(int c) override
+  {
+    return c;
+  }
+  std::streamsize xsputn(const char *, std::streamsize count) override
+  {
+    return count;
+  }
+};
+
+// this holds the options of a benchmark run
+struct benchOptionsStruct
+{
+  double minSeconds;  // the minimum time to run each case
+  std::string filter; // only the cases whose names contain this are run
+};
+
+// a value that the cases add their results to so the compiler can't remove the work
+static volatile double benchSink = 0;
+
+// run a case and report its rate
+// name - the name of the case
+// rows - the number of rows that one run of the case processes
+// bytes - the number of bytes of epw text that one run processes (0 to not report MB/s)
+// run - the case
+static void runCase(const benchOptionsStruct &options, const std::string &name, size_t rows, size_t bytes,
+  const std::function<void()> &run)
+{
+  if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+  {
+    return;
+  }
+  // warm up the caches once before timing
+  run();
+  double best = 1e300;
+  double total = 0;
+  int runs = 0;
+  while (total < options.minSeconds || runs < 3)
+  {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    best = std::min(best, seconds);
+    total += seconds;
+    ++runs;
+  }
+  printf("%-44s %12.0f rows/s", name.c_str(), rows / best);
+  if (bytes > 0)
+  {
+    printf(" %10.1f MB/s", bytes / best / 1e6);
+  }
+  else
+  {
+    printf(" %15s", "");
+  }
+  printf(" %10.3f ms/run\n", best * 1e3);
+}
+
+// get the lines of the data section of an epw file
+static std::vector<std::string> dataLines(const std::string &epw)
+{
+  std::vector<std::string> lines;
+  size_t begin = 0;
+  for (int line = 0; begin < epw.length(); ++line)
+  {
+    size_t end = epw.find('\n', begin);
+    if (end == std::string::npos)
+    {
+      end = epw.length();
+    }
+    // the data starts on line 9
+    if (line >= 8)
+    {
+      lines.push_back(epw.substr(begin, end - begin));
+    }
+    begin = end + 1;
+  }
+  return lines;
+}
+
+// the config of a conversion with the default options
+static configStruct defaultConfig()
+{
+  configStruct config;
+  config.useDST = 0;
+  config.startDate = -1;
+  config.endDate = -1;
+  config.firstDOY = 1;
+  config.validConfig = 1;
+  return config;
+}
+
+// the benchmarks of the parts of a conversion on one file
+static void benchmarkParts(const benchOptionsStruct &options, const std::string &epw)
+{
+  std::vector<std::string> lines = dataLines(epw);
+  size_t rows = lines.size();
+  size_t bytes = 0;
+  for (const std::string &line : lines)
+  {
+    bytes += line.length() + 1;
+  }
+  const char *dataBegin = epw.data() + epw.length() - bytes;
+
+  runCase(options, "split", rows, bytes, [&]()
+  {
+    std::vector<std::string> elems;
+    size_t count = 0;
+    for (const std::string &line : lines)
+    {
+      elems.clear();
+      count += split(line, ',', elems).size();
+    }
+    benchSink = benchSink + count;
+  });
+
+  runCase(options, "tokenizeEPWRow", rows, bytes, [&]()
+  {
+    epwRowStruct row;
+    size_t count = 0;
+    for (const char *cursor = dataBegin; cursor < epw.data() + epw.length();)
+    {
+      cursor = tokenizeEPWRow(cursor, epw.data() + epw.length(), row);
+      count += row.fieldCount;
+    }
+    benchSink = benchSink + count;
+  });
+
+  // parse the fields of every line into records
+  std::vector<wthRecordStruct> records(rows);
+  std::vector<float> dryBulbK(rows);
+  std::vector<float> dewPointK(rows);
+  std::vector<float> pressure(rows);
+  std::vector<float> tenthsCloudCover(rows);
+  runCase(options, "tokenizeEPWRow+parseDataLine", rows, bytes, [&]()
+  {
+    epwRowStruct row;
+    int errField;
+    std::string errMsg;
+    size_t index = 0;
+    for (const char *cursor = dataBegin; cursor < epw.data() + epw.length(); ++index)
+    {
+      cursor = tokenizeEPWRow(cursor, epw.data() + epw.length(), row);
+      parseDataLine(row, 1, 365, records[index], dewPointK[index], tenthsCloudCover[index], errField, errMsg);
+    }
+  });
+  for (size_t index = 0; index < rows; ++index)
+  {
+    dryBulbK[index] = records[index].Ta;
+    pressure[index] = records[index].Pb;
+  }
+
+  runCase(options, "satpt", rows, 0, [&]()
+  {
+    double sum = 0;
+    for (size_t index = 0; index < rows; ++index)
+    {
+      sum += satpt(dewPointK[index]);
+    }
+    benchSink = benchSink + sum;
+  });
+
+  runCase(options, "psywdp", rows, 0, [&]()
+  {
+    double sum = 0;
+    for (size_t index = 0; index < rows; ++index)
+    {
+      sum += psywdp(dewPointK[index], pressure[index]);
+    }
+    benchSink = benchSink + sum;
+  });
+
+  runCase(options, "skyTf", rows, 0, [&]()
+  {
+    double sum = 0;
+    for (size_t index = 0; index < rows; ++index)
+    {
+      sum += skyTf(dryBulbK[index], dewPointK[index], tenthsCloudCover[index]);
+    }
+    benchSink = benchSink + sum;
+  });
+
+  std::vector<float> humidityRatio(rows);
+  std::vector<float> skyTemperature(rows);
+  runCase(options, "psychrometricsBatch", rows, 0, [&]()
+  {
+    psychrometricsBatch(dryBulbK.data(), dewPointK.data(), pressure.data(), tenthsCloudCover.data(),
+      humidityRatio.data(), skyTemperature.data(), rows);
+    benchSink = benchSink + humidityRatio[rows / 2];
+  });
+
+  runCase(options, "IntDateXToStringDateX+IntTimeToStringTime", rows, 0, [&]()
+  {
+    size_t length = 0;
+    for (size_t index = 0; index < rows; ++index)
+    {
+      length += IntDateXToStringDateX(records[index].date).length();
+      length += IntTimeToStringTime(records[index].time).length();
+    }
+    benchSink = benchSink + length;
+  });
+
+  runCase(options, "wthWriter::writeRecord", rows, 0, [&]()
+  {
+    wthWriter writer(NULL, -1);
+    for (size_t index = 0; index < rows; ++index)
+    {
+      writer.writeRecord(records[index], records[index].time);
+    }
+    benchSink = benchSink + writer.output().length();
+  });
+}
+
+// the benchmarks of whole conversions of a file
+static void benchmarkConvert(const benchOptionsStruct &options, const std::string &name, const std::string &epw)
+{
+  size_t rows = std::count(epw.begin(), epw.end(), '\n') - 8;
+  nullStreambuf nullBuffer;
+  std::ostream nullStream(&nullBuffer);
+
+  configStruct config = defaultConfig();
+  runCase(options, "convertEPW " + name, rows, epw.length(), [&]()
+  {
+    if (convertEPW(config, epw.data(), epw.data() + epw.length(), nullStream) != 0)
+    {
+      std::cerr << "The conversion of " << name << " failed." << std::endl;
+    }
+  });
+
+  // the same conversion on one thread per processor
+  configStruct threadedConfig = defaultConfig();
+  threadedConfig.dataThreads = 0;
+  runCase(options, "convertEPW -j 0 " + name, rows, epw.length(), [&]()
+  {
+    convertEPW(threadedConfig, epw.data(), epw.data() + epw.length(), nullStream);
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  benchOptionsStruct options;
+  options.minSeconds = 1.0;
+  bool quick = false;
+  std::string generateDir;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string argi = argv[i];
+    if (argi == "--quick")
+    {
+      quick = true;
+      options.minSeconds = 0.2;
+    }
+    else if (argi == "--filter" && i + 1 < argc)
+    {
+      options.filter = argv[++i];
+    }
+    else if (argi == "--generate" && i + 1 < argc)
+    {
+      generateDir = argv[++i];
+    }
+    else
+    {
+      std::cerr << "Usage: epwBenchmark [--quick] [--filter <Text>] [--generate <Directory>]" << std::endl;
+      return 1;
+    }
+  }
+
+  // the synthetic files from the most common to the largest
+  std::vector<epwGeneratorStruct> generators = { { 60, 1, 1 }, { 10, 1, 2 }, { 60, 10, 3 }, { 1, 1, 4 } };
+  if (quick)
+  {
+    generators.pop_back();
+  }
+
+  if (!generateDir.empty())
+  {
+    for (const epwGeneratorStruct &generator : generators)
+    {
+      std::string path = generateDir + "/" + epwGeneratorName(generator) + ".epw";
+      std::ofstream epwStream(path, std::ios::binary);
+      epwStream << generateEPW(generator);
+      epwStream.close();
+      if (epwStream.fail())
+      {
+        std::cerr << "Failed to write " << path << std::endl;
+        return 1;
+      }
+      std::cout << "Generated " << path << std::endl;
+    }
+    return 0;
+  }
+
+  // the parts are timed on the hourly file, the most common kind
+  std::string hourly = generateEPW(generators[0]);
+  printf("parts of a conversion (%s)\n", epwGeneratorName(generators[0]).c_str());
+  benchmarkParts(options, hourly);
+  printf("\nwhole conversions\n");
+  for (const epwGeneratorStruct &generator : generators)
+  {
+    benchmarkConvert(options, epwGeneratorName(generator), generateEPW(generator));
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include "epwGenerator.h"
+#include "../src/dateTables.h"
+
+#include <cstdio>
+#include <string>
+
+// the next number of a small random number generator (xorshift64*)
+// it is used instead of <random> so the files are the same with every compiler
+static unsigned long long nextRandom(unsigned long long &state)
+{
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+// a random value from min to max
+static double randomValue(unsigned long long &state, double min, double max)
+{
+  return min + (max - min) * (double)(nextRandom(state) >> 11) / (double)(1ULL << 53);
+}
+
+// a random integer from min to max
+static int randomInteger(unsigned long long &state, int min, int max)
+{
+  return min + (int)(nextRandom(state) % (unsigned long long)(max - min + 1));
+}
+
+// generate the text of a synthetic epw file
+// the fields that the converter uses get plausible values that vary from line to line
+// so that the parsing and the formatting are not helped by repeated text
+// generator - the length and the interval of the data
+// return the epw file
+std::string generateEPW(const epwGeneratorStruct &generator)
+{
+  // the state of xorshift can't be 0
+  unsigned long long random = generator.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+  int recordsPerHour = generator.minutesPerRecord < 60 ? 60 / generator.minutesPerRecord : 1;
+  std::string epw;
+  epw.reserve((size_t)generator.years * 365 * 24 * recordsPerHour * 170 + 1024);
+  char line[512];
+  snprintf(line, sizeof(line), "LOCATION,Synthetic %llu,ST,USA,TMY3,999999,40.1,-88.2,-6.0,200.0\n",
+    generator.seed);
+  epw += line;
+  epw += "DESIGN CONDITIONS,0\nTYPICAL/EXTREME PERIODS,0\nGROUND TEMPERATURES,0\n";
+  epw += "HOLIDAYS/DAYLIGHT SAVINGS,No,0,0,0\nCOMMENTS 1,synthetic\nCOMMENTS 2,synthetic\n";
+  snprintf(line, sizeof(line), "DATA PERIODS,1,%d,Data,Sunday, 1/ 1,12/31\n", recordsPerHour);
+  epw += line;
+
+  static const int SKY_COVER[] = { 0, 1, 2, 5, 9, 10, 99 };
+  static const char *WEATHER_CODES[] = { "999999999", "919999999", "099999999", "929999999", "989999999" };
+  static const int SNOW_DEPTH[] = { 0, 0, 0, 1, 2, 15, 999 };
+  for (int year = 0; year < generator.years; ++year)
+  {
+    for (int month = 1; month <= 12; ++month)
+    {
+      for (int day = 1; day <= LENGTH_OF_MONTH[month - 1]; ++day)
+      {
+        // each record is at the end of its interval, the last one of the day is 24:00
+        for (int minutes = generator.minutesPerRecord; minutes <= MINUTES_PER_DAY;
+          minutes += generator.minutesPerRecord)
+        {
+          int hour = (minutes - 1) / 60 + 1;
+          int minute = generator.minutesPerRecord >= 60 ? 0 : minutes - (hour - 1) * 60;
+          // the values are drawn one statement at a time since the order that arguments are
+          // evaluated in is up to the compiler
+          double dryBulb = randomValue(random, -30, 40);
+          double dewPoint = dryBulb - randomValue(random, 0, 15);
+          int humidity = randomInteger(random, 10, 100);
+          int pressure = randomInteger(random, 85000, 104000);
+          int infrared = randomInteger(random, 200, 400);
+          int globalHorizontal = randomInteger(random, 0, 900);
+          int directNormal = randomInteger(random, 0, 900);
+          int diffuseHorizontal = randomInteger(random, 0, 400);
+          int windDirection = randomInteger(random, 0, 360);
+          double windSpeed = randomValue(random, 0, 15);
+          int totalSkyCover = SKY_COVER[randomInteger(random, 0, 6)];
+          int opaqueSkyCover = randomInteger(random, 0, 10);
+          const char *weatherCodes = WEATHER_CODES[randomInteger(random, 0, 4)];
+          int precipitableWater = randomInteger(random, 0, 50);
+          int snowDepth = SNOW_DEPTH[randomInteger(random, 0, 6)];
+          snprintf(line, sizeof(line),
+            "%d,%d,%d,%d,%d,?9?9?9?9E0?9?9?9?9?9?9?9?9?9?9?9?9?9*9*9?9?9?9,%.1f,%.1f,%d,%d,0,1415,%d,%d,%d,%d,"
+            "0,0,0,0,%d,%.1f,%d,%d,16.1,77777,9,%s,%d,0.1,%d,88,0.2,0,0\n",
+            1999 + year, month, day, hour, minute, dryBulb, dewPoint, humidity, pressure, infrared,
+            globalHorizontal, directNormal, diffuseHorizontal, windDirection, windSpeed, totalSkyCover,
+            opaqueSkyCover, weatherCodes, precipitableWater, snowDepth);
+          epw += line;
+        }
+      }
+    }
+  }
+  return epw;
+}
+
+// a short name of a synthetic epw file for reports and file names (e.g. 10min_1y)
+std::string epwGeneratorName(const epwGeneratorStruct &generator)
+{
+  std::string name = generator.minutesPerRecord == 60 ? "hourly" :
+    std::to_string(generator.minutesPerRecord) + "min";
+  return name + "_" + std::to_string(generator.years) + "y";
+}
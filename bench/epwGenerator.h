@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+
+// this describes a synthetic epw file
+struct epwGeneratorStruct
+{
+  int minutesPerRecord;    // the minutes between records (60 = hourly, 10, 1 ...)
+  int years;               // the number of years of data, the same calendar is repeated each year
+  unsigned long long seed; // the seed of the values, the same seed always gives the same file
+};
+
+std::string generateEPW(const epwGeneratorStruct &generator);
+std::string epwGeneratorName(const epwGeneratorStruct &generator);
@@ -1,63 +1,51 @@
 #include "EPWConverter.h"
 #include "utils.h"
+#include "EPWTokenizer.h"
+#include "threadPool.h"
+#include "wthWriter.h"
+#include "dateTables.h"
+#include "psychrometrics.h"
+#include "epwBinary.h"
+#include "epwArchive.h"
+#include "conversionStats.h"
+#include "dayCalendar.h"
+#include "epwNumber.h"
 
 #include <string>
 #include <vector>
 #include <iostream>
+#include <iterator>
+#include <cstring>
+#include <algorithm>
+#include <memory>
 
 // output the day type definitions in the header section of the weather file
-void outputWthHeaderDays(int startDate, int endDate, std::ostream &ostream,
-  int &dayOfWeek, int &dayType, configStruct config)
+// the days are looked up in the calendar of the config
+void outputWthHeaderDays(int startDate, int endDate, wthWriter &writer, const dayCalendarStruct &calendar)
 {
   for (int currentDate = startDate; currentDate <= endDate; ++currentDate)
   {
-    // check if DST should be use for the current date
-    int daylightSavings;
-    if (config.useDST && dateIsWithinRange(currentDate, config.startDateDST, config.endDateDST))
-    {
-      daylightSavings = 1;
-    }
-    else
-    {
-      daylightSavings = 0;
-    }
-
-    //check for special days
-    int dType = dayType;
-    for (size_t index = 0; index < config.specialDays.size(); ++index)
-    {
-      if (currentDate == config.specialDays[index].date)
-      {
-        dType = config.specialDays[index].dtype;
-      }
-    }
-
-    ostream << IntDateXToStringDateX(currentDate) << '\t'
-      << dayOfWeek << '\t' << dType << '\t'
-      << daylightSavings << '\t' << "283.15" << std::endl;
-    dayOfWeek++;
-    if (dayOfWeek > 7)
-    {
-      dayOfWeek = 1;
-    }
-
-    dayType++;
-    if (dayType > 7)
-    {
-      dayType = 1;
-    }
+    writer.writeDay(currentDate, calendar.dayOfWeek[currentDate], calendar.dayType[currentDate],
+      calendar.daylightSavings[currentDate]);
   }
 }
 
 // read a line of data from the epw file
-// output a corresponding line to the wth file
-// lineitems - a vector of strings for a line of data from the epw file
-// ostream - the output stream to write data to the wth file
-// firstRecord - this is true if this is the first record of data to be processed
+// and compute the corresponding record of the wth file
+// lineItems - the fields for a line of data from the epw file
 // startDate - the date to start outputing data
 // endDate - the date to end outputing data
-void processDataLine(std::vector<std::string> &lineItems, std::ostream &ostream, 
-  bool &firstRecord, int startDate, int endDate)
+// record - receives the record for the wth file
+//   the humidity ratio and sky temperature are left for computeRecordBatch
+// dewPointTemperatureK - receives the dew point temperature [K]
+// tenthsCloudCover - receives the tenths of cloud cover
+// errField - receives the field of the line (1 based) with the problem if the line can't be processed
+// errMsg - receives a description of the problem if the line can't be processed
+// return 0 if the record was read, 1 if the line is outside of the dates to output
+// and -1 if the line could not be processed
+int parseDataLine(const epwRowStruct &lineItems, int startDate, int endDate,
+  wthRecordStruct &record, float &dewPointTemperatureK, float &tenthsCloudCover, int &errField,
+  std::string &errMsg)
 {
   /*    The EE values are stored as comma delimited data --
   *       field        description
@@ -80,142 +68,127 @@ void processDataLine(std::vector<std::string> &lineItems, std::ostream &ostream,
   // the values above are 1 based
   // the values below are 0 based
 
+  // make sure that all of the columns that are used are present
+  if (lineItems.fieldCount < EPW_USED_FIELDS)
+  {
+    errField = lineItems.fieldCount + 1;
+    errMsg = "Too few fields in a line of data. (" + std::to_string(lineItems.fieldCount) + ")";
+    return -1;
+  }
+
   // get columns that we need from the data
   // and do calculations as needed to get the items we need for the wth file
-  int month = std::stoi(lineItems[1]);
-  int day = std::stoi(lineItems[2]);
+  int month;
+  if (parseEPWInt(lineItems.fields[1], month) != 0)
+  {
+    errField = 2;
+    errMsg = "Failed to parse the month. (" + std::string(lineItems.fields[1]) + ")";
+    return -1;
+  }
+  int day;
+  if (parseEPWInt(lineItems.fields[2], day) != 0)
+  {
+    errField = 3;
+    errMsg = "Failed to parse the day. (" + std::string(lineItems.fields[2]) + ")";
+    return -1;
+  }
   int doy = doyFromMonthAndDay(month, day);
 
   // if the doy for this record is not in range then skip it
   if (!dateIsWithinRange(doy, startDate, endDate))
   {
-    return;
+    return 1;
   }
 
   int hour;
-  try
-  {
-    hour = std::stoi(lineItems[3]);
-  }
-  catch (...)
+  if (parseEPWInt(lineItems.fields[3], hour) != 0)
   {
-    std::cerr << "Failed to parse the hour. (" + lineItems[3] + ")";
-    exit(1);
+    errField = 4;
+    errMsg = "Failed to parse the hour. (" + std::string(lineItems.fields[3]) + ")";
+    return -1;
   }
   int minute;
-  try
-  {
-    minute = std::stoi(lineItems[4]);
-  }
-  catch (...)
+  if (parseEPWInt(lineItems.fields[4], minute) != 0)
   {
-    std::cerr << "Failed to parse the minute. (" + lineItems[4] + ")";
-    exit(1);
+    errField = 5;
+    errMsg = "Failed to parse the minute. (" + std::string(lineItems.fields[4]) + ")";
+    return -1;
   }
   //compute the number of seconds of the day
   int time = hour * 3600 + minute * 60;
 
   float dryBuldTemperatureC;
-  try
-  {
-    dryBuldTemperatureC = std::stof(lineItems[6]);
-  }
-  catch (...)
+  if (parseEPWFloat(lineItems.fields[6], dryBuldTemperatureC) != 0)
   {
-    std::cerr << "Failed to parse the dry bulb temperature. (" + lineItems[6] + ")";
-    exit(1);
+    errField = 7;
+    errMsg = "Failed to parse the dry bulb temperature. (" + std::string(lineItems.fields[6]) + ")";
+    return -1;
   }
   float dryBulbTemperatureK = 273.15f + dryBuldTemperatureC;
   float dewPointTemperatureC;
-  try
-  {
-    dewPointTemperatureC = std::stof(lineItems[7]);
-  }
-  catch (...)
+  if (parseEPWFloat(lineItems.fields[7], dewPointTemperatureC) != 0)
   {
-    std::cerr << "Failed to parse the dew point temperature. (" + lineItems[7] + ")";
-    exit(1);
+    errField = 8;
+    errMsg = "Failed to parse the dew point temperature. (" + std::string(lineItems.fields[7]) + ")";
+    return -1;
   }
-  float dewPointTemperatureK = 273.15f + dewPointTemperatureC;
+  dewPointTemperatureK = 273.15f + dewPointTemperatureC;
   float barometricPressure;
-  try
+  if (parseEPWFloat(lineItems.fields[9], barometricPressure) != 0)
   {
-    barometricPressure = std::stof(lineItems[9]);
-  }
-  catch (...)
-  {
-    std::cerr << "Failed to parse the barometric pressure. (" + lineItems[9] + ")";
-    exit(1);
+    errField = 10;
+    errMsg = "Failed to parse the barometric pressure. (" + std::string(lineItems.fields[9]) + ")";
+    return -1;
   }
   float windSpeed;
-  try
+  if (parseEPWFloat(lineItems.fields[21], windSpeed) != 0)
   {
-    windSpeed = std::stof(lineItems[21]);
-  }
-  catch (...)
-  {
-    std::cerr << "Failed to parse the wind speed. (" + lineItems[21] + ")";
-    exit(1);
+    errField = 22;
+    errMsg = "Failed to parse the wind speed. (" + std::string(lineItems.fields[21]) + ")";
+    return -1;
   }
   float windDirection;
-  try
+  if (parseEPWFloat(lineItems.fields[20], windDirection) != 0)
   {
-    windDirection = std::stof(lineItems[20]);
-  }
-  catch (...)
-  {
-    std::cerr << "Failed to parse the wind direction. (" + lineItems[20] + ")";
-    exit(1);
+    errField = 21;
+    errMsg = "Failed to parse the wind direction. (" + std::string(lineItems.fields[20]) + ")";
+    return -1;
   }
-  float humidityRaito = 1000.0f * psywdp(dewPointTemperatureK, barometricPressure);
-
   float totalHorizontalSolarRadiation1;
-  try
+  if (parseEPWFloat(lineItems.fields[13], totalHorizontalSolarRadiation1) != 0)
   {
-    totalHorizontalSolarRadiation1 = std::stof(lineItems[13]);
-  }
-  catch (...)
-  {
-    std::cerr << "Failed to parse the total horizontal solar radiation. (" + lineItems[13] + ")";
-    exit(1);
+    errField = 14;
+    errMsg = "Failed to parse the total horizontal solar radiation. (" + std::string(lineItems.fields[13]) + ")";
+    return -1;
   }
   float totalHorizontalSolarRadiation2 = 3.6f * totalHorizontalSolarRadiation1; /* [Wh/m^2] to [kJ/m^2] */
   float directNormalSolarRadiation1;
-  try
+  if (parseEPWFloat(lineItems.fields[14], directNormalSolarRadiation1) != 0)
   {
-    directNormalSolarRadiation1 = std::stof(lineItems[14]);
-  }
-  catch (...)
-  {
-    std::cerr << "Failed to parse the direction normal solar radiation. (" + lineItems[14] + ")";
-    exit(1);
+    errField = 15;
+    errMsg = "Failed to parse the direction normal solar radiation. (" + std::string(lineItems.fields[14]) + ")";
+    return -1;
   }
   float directNormalSolarRadiation2 = 3.6f * directNormalSolarRadiation1; /* [Wh/m^2] to [kJ/m^2] */
-  float tenthsCloudCover = 0.0;
+  tenthsCloudCover = 0.0;
   float totalSkyCover;
-  try
-  {
-    totalSkyCover = std::stof(lineItems[22]);
-  }
-  catch (...)
+  if (parseEPWFloat(lineItems.fields[22], totalSkyCover) != 0)
   {
-    std::cerr << "Failed to parse the total sky cover.(" + lineItems[22] + ")";
-    exit(1);
+    errField = 23;
+    errMsg = "Failed to parse the total sky cover.(" + std::string(lineItems.fields[22]) + ")";
+    return -1;
   }
   if (totalSkyCover != 99)
     tenthsCloudCover = 0.1f * totalSkyCover;
-  float skyRadiantTemprerature = skyTf(dryBulbTemperatureK, dewPointTemperatureK, tenthsCloudCover);
 
-  std::string WeatherCodes = lineItems[27];
+  std::string_view WeatherCodes = lineItems.fields[27];
   int rainCode;
-  try
-  {
-    rainCode = std::stoi(WeatherCodes.substr(1, 1));
-  }
-  catch (...)
+  // the rain is the second digit of the weather codes
+  if (WeatherCodes.length() < 2 || parseEPWInt(WeatherCodes.substr(1, 1), rainCode) != 0)
   {
-    std::cerr << "Failed to parse the weather codes. (" + WeatherCodes + ")";
-    exit(1);
+    errField = 28;
+    errMsg = "Failed to parse the weather codes. (" + std::string(WeatherCodes) + ")";
+    return -1;
   }
   int rain;
   if (rainCode >= 1 && rainCode <= 8)
@@ -225,40 +198,487 @@ void processDataLine(std::vector<std::string> &lineItems, std::ostream &ostream,
 
   int snow;
   int snowDepth;
-  try
-  {
-    snowDepth = std::stoi(lineItems[30]);
-  }
-  catch (...)
+  if (parseEPWInt(lineItems.fields[30], snowDepth) != 0)
   {
-    std::cerr << "Failed to parse the snow depth. (" + lineItems[30] + ")";
-    exit(1);
+    errField = 31;
+    errMsg = "Failed to parse the snow depth. (" + std::string(lineItems.fields[30]) + ")";
+    return -1;
   }
   if (snowDepth > 1)
     snow = 1;
   else
     snow = 0;
 
-  // if this is the first record of data and the time != 0
-  if (firstRecord && time != 0)
+  record.date = doy;
+  record.time = time;
+  record.Ta = dryBulbTemperatureK;
+  record.Pb = barometricPressure;
+  record.Ws = windSpeed;
+  record.Wd = windDirection;
+  record.Ith = totalHorizontalSolarRadiation2;
+  record.Idn = directNormalSolarRadiation2;
+  record.Rn = rain;
+  record.Sn = snow;
+
+  return 0;
+}
+
+// the number of records whose humidity ratio and sky temperature are computed together
+const int RECORD_BATCH_SIZE = 256;
+
+// this holds a batch of records that are waiting for their humidity ratio and sky temperature
+struct recordBatchStruct
+{
+  wthRecordStruct records[RECORD_BATCH_SIZE];
+  float dewPointK[RECORD_BATCH_SIZE];
+  float tenthsCloudCover[RECORD_BATCH_SIZE];
+  int count;
+};
+
+// compute the humidity ratio and sky temperature of the records in a batch
+// with the vectorized psychrometric functions
+void computeRecordBatch(recordBatchStruct &batch)
+{
+  float dryBulbK[RECORD_BATCH_SIZE];
+  float pressure[RECORD_BATCH_SIZE];
+  float humidityRatio[RECORD_BATCH_SIZE];
+  float skyTemperature[RECORD_BATCH_SIZE];
+  for (int index = 0; index < batch.count; ++index)
+  {
+    dryBulbK[index] = batch.records[index].Ta;
+    pressure[index] = batch.records[index].Pb;
+  }
+  psychrometricsBatch(dryBulbK, batch.dewPointK, pressure, batch.tenthsCloudCover,
+    humidityRatio, skyTemperature, batch.count);
+  for (int index = 0; index < batch.count; ++index)
+  {
+    batch.records[index].Hr = humidityRatio[index];
+    batch.records[index].Ts = skyTemperature[index];
+  }
+}
+
+// get the next line from a buffer
+// cursor - the start of the line
+// end - the end of the buffer
+// line - receives the line without its newline (the same as std::getline)
+//   a carriage return before the newline is dropped the same way a text mode stream drops it
+// return the start of the following line
+const char *getLine(const char *cursor, const char *end, std::string_view &line)
+{
+  const char *newline = (const char *)memchr(cursor, '\n', end - cursor);
+  const char *next = newline ? newline + 1 : end;
+  const char *lineEnd = newline ? newline : end;
+  if (lineEnd > cursor && lineEnd[-1] == '\r')
+  {
+    --lineEnd;
+  }
+  line = std::string_view(cursor, lineEnd - cursor);
+  return next;
+}
+
+// return true if there is no line at the cursor or the line is empty
+bool lineIsEmpty(const char *cursor, const char *end)
+{
+  if (cursor < end && *cursor == '\r')
+  {
+    ++cursor;
+  }
+  return cursor >= end || *cursor == '\n';
+}
+
+// write the records of a batch once their psychrometrics have been computed
+// writeTimeZeroRecord - true to write a time 0 copy of the chunk's first record if it is not at time 0
+void writeRecordBatch(recordBatchStruct &batch, dataChunkStruct &chunk, wthWriter &writer,
+  bool writeTimeZeroRecord)
+{
+  conversionStatsStruct *stats = chunk.stats;
+  double mark = stats ? statsClock() : 0;
+  computeRecordBatch(batch);
+  addStageTime(stats, STAGE_PSYCHROMETRICS, mark);
+  // the time to write full blocks to the stream is part of formatting the records, it is measured on its own
+  double writeSeconds = stats ? stats->stageSeconds[STAGE_WRITE] : 0;
+  for (int index = 0; index < batch.count; ++index)
+  {
+    const wthRecordStruct &record = batch.records[index];
+    if (!chunk.hasRecord)
+    {
+      chunk.firstRecord = record;
+      chunk.hasRecord = true;
+      if (writeTimeZeroRecord)
+      {
+        writer.writeFirstRecord(record);
+      }
+    }
+    // write data to wth file
+    writer.writeRecord(record, record.time);
+  }
+  batch.count = 0;
+  addStageTime(stats, STAGE_FORMAT, mark);
+  if (stats)
+  {
+    stats->stageSeconds[STAGE_FORMAT] -= stats->stageSeconds[STAGE_WRITE] - writeSeconds;
+  }
+}
+
+// convert the lines of a chunk of the data section
+// the lines are read in batches so the psychrometrics of a batch can be computed together
+// chunk - the lines to convert, receives the result
+// startDate - the date to start outputing data
+// endDate - the date to end outputing data
+// writer - writes the records
+// writeTimeZeroRecord - true if the chunk's first record is the first record of the file
+//   so a time 0 copy of it is written when needed, when the file is converted on several threads
+//   only the chunk that holds the first record of the whole file knows that it needs it
+void convertDataLines(dataChunkStruct &chunk, int startDate, int endDate, wthWriter &writer,
+  bool writeTimeZeroRecord)
+{
+  epwRowStruct row;
+  recordBatchStruct batch;
+  const char *cursor = chunk.begin;
+
+  batch.count = 0;
+  conversionStatsStruct *stats = chunk.stats;
+  double mark = stats ? statsClock() : 0;
+  chunk.hasRecord = false;
+  chunk.lineCount = 0;
+  chunk.reachedEmptyLine = false;
+  chunk.retVal = 0;
+  // process the lines of data until the end of the chunk or an empty line
+  while (cursor < chunk.end)
+  {
+    if (lineIsEmpty(cursor, chunk.end))
+    {
+      chunk.reachedEmptyLine = true;
+      break;
+    }
+    // find the fields of the line without copying them
+    cursor = tokenizeEPWRow(cursor, chunk.end, row);
+    addStageTime(stats, STAGE_TOKENIZE, mark);
+
+    int retVal = parseDataLine(row, startDate, endDate, batch.records[batch.count],
+      batch.dewPointK[batch.count], batch.tenthsCloudCover[batch.count], chunk.errField, chunk.errMsg);
+    addStageTime(stats, STAGE_PARSE, mark);
+    if (stats)
+    {
+      ++stats->rowsRead;
+      stats->rowsSkipped += retVal == 1;
+    }
+    if (retVal == -1)
+    {
+      chunk.retVal = -1;
+      break;
+    }
+    if (retVal == 0 && ++batch.count == RECORD_BATCH_SIZE)
+    {
+      writeRecordBatch(batch, chunk, writer, writeTimeZeroRecord);
+      // the batch measured its own time
+      mark = stats ? statsClock() : 0;
+    }
+    ++chunk.lineCount;
+  }
+  writeRecordBatch(batch, chunk, writer, writeTimeZeroRecord);
+}
+
+// convert one chunk of the data section into the chunk's own output
+void convertDataChunk(dataChunkStruct &chunk, int startDate, int endDate, int precision)
+{
+  wthWriter chunkWriter(NULL, precision);
+  chunkWriter.measure(chunk.stats);
+  convertDataLines(chunk, startDate, endDate, chunkWriter, false);
+  chunk.output = chunkWriter.takeOutput();
+}
+
+// describe a line of the epw file that could not be processed
+void setLineError(conversionErrorStruct &error, int line, int field, const std::string &errMsg)
+{
+  error.type = CONVERSION_ERROR_DATA;
+  error.line = line;
+  error.field = field;
+  error.errMsg = "Line " + std::to_string(line) + ": " + errMsg;
+}
+
+// convert a range of lines of the data section on several threads
+// the range is split into chunks at line boundaries, the chunks are converted at the same time
+// and then their output is written in order so it is the same as convertDataLines
+// range - the lines to convert, receives the result the same as convertDataLines
+//   the times of the threads are added up in its stats
+// startDate - the date to start outputing data
+// endDate - the date to end outputing data
+// writer - writes the records to the wth file
+// writeTimeZeroRecord - true if the range's first record is the first record of the file
+// precision - the number of decimals to write for the floats (-1 = the same as a default stream)
+// threadCount - the number of threads to use, 0 means one per hardware thread
+void convertDataChunks(dataChunkStruct &range, int startDate, int endDate, wthWriter &writer,
+  bool writeTimeZeroRecord, int precision, int threadCount)
+{
+  const char *dataBegin = range.begin;
+  const char *dataEnd = range.end;
+  conversionStatsStruct *stats = range.stats;
+  const size_t minimumChunkSize = 64 * 1024;
+  if (threadCount <= 0)
+  {
+    threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+
+  // use a few chunks per thread so that the threads finish at about the same time
+  size_t dataSize = dataEnd - dataBegin;
+  size_t chunkCount = std::min<size_t>((size_t)threadCount * 4, dataSize / minimumChunkSize);
+  if (chunkCount < 1)
+  {
+    chunkCount = 1;
+  }
+
+  // end each chunk at the end of a line
+  // each chunk is measured on its own so the threads don't share the counters
+  std::vector<dataChunkStruct> chunks(chunkCount);
+  std::vector<conversionStatsStruct> chunkStats(stats ? chunkCount : 0);
+  const char *chunkBegin = dataBegin;
+  for (size_t index = 0; index < chunkCount; ++index)
+  {
+    const char *chunkEnd = dataEnd;
+    if (index + 1 < chunkCount)
+    {
+      chunkEnd = std::max(chunkBegin, dataBegin + dataSize * (index + 1) / chunkCount);
+      const char *newline = (const char *)memchr(chunkEnd, '\n', dataEnd - chunkEnd);
+      chunkEnd = newline ? newline + 1 : dataEnd;
+    }
+    chunks[index].begin = chunkBegin;
+    chunks[index].end = chunkEnd;
+    chunks[index].stats = NULL;
+    if (stats)
+    {
+      resetConversionStats(chunkStats[index]);
+      chunks[index].stats = &chunkStats[index];
+    }
+    chunkBegin = chunkEnd;
+  }
+
+  if (chunkCount == 1)
+  {
+    // too little data to be worth sharing
+    convertDataChunk(chunks[0], startDate, endDate, precision);
+  }
+  else
+  {
+    threadPool pool(std::min<unsigned int>((unsigned int)threadCount, (unsigned int)chunkCount));
+    for (size_t index = 0; index < chunkCount; ++index)
+    {
+      dataChunkStruct &chunk = chunks[index];
+      pool.submit([&chunk, startDate, endDate, precision]()
+      {
+        convertDataChunk(chunk, startDate, endDate, precision);
+      });
+    }
+    pool.wait();
+  }
+  for (size_t index = 0; index < chunkStats.size(); ++index)
+  {
+    addConversionStats(*stats, chunkStats[index]);
+  }
+
+  // write the chunks in order
+  range.hasRecord = false;
+  range.lineCount = 0;
+  range.reachedEmptyLine = false;
+  range.retVal = 0;
+  for (size_t index = 0; index < chunkCount; ++index)
+  {
+    const dataChunkStruct &chunk = chunks[index];
+    if (!range.hasRecord && chunk.hasRecord)
+    {
+      range.firstRecord = chunk.firstRecord;
+      range.hasRecord = true;
+      if (writeTimeZeroRecord)
+      {
+        writer.writeFirstRecord(chunk.firstRecord);
+      }
+    }
+    writer.writeText(chunk.output);
+    range.lineCount += chunk.lineCount;
+    if (chunk.retVal != 0)
+    {
+      range.retVal = -1;
+      range.errField = chunk.errField;
+      range.errMsg = chunk.errMsg;
+      return;
+    }
+    if (chunk.reachedEmptyLine)
+    {
+      range.reachedEmptyLine = true;
+      break;
+    }
+  }
+}
+
+// read the year and the day of the year of a line of data
+// return 0 if they were read and -1 if the line is empty or they can't be read
+static int readLineDate(const char *line, const char *end, int &year, int &date)
+{
+  if (lineIsEmpty(line, end))
+  {
+    return -1;
+  }
+  epwRowStruct row;
+  tokenizeEPWRow(line, end, row);
+  if (row.fieldCount < 3)
+  {
+    return -1;
+  }
+  int month;
+  int day;
+  if (parseEPWInt(row.fields[0], year) != 0 || parseEPWInt(row.fields[1], month) != 0 ||
+    parseEPWInt(row.fields[2], day) != 0)
+  {
+    return -1;
+  }
+  date = doyFromMonthAndDay(month, day);
+  return date == -1 ? -1 : 0;
+}
+
+// find the first line of sorted data whose day of the year is at least a date with a binary search
+// dataBegin - the first line of data
+// dataEnd - the end of the data
+// date - the date to find
+// return the line, dataEnd if every line is before the date and NULL if a line can't be read
+static const char *findFirstLineOfDate(const char *dataBegin, const char *dataEnd, int date)
+{
+  // the lines before low are before the date and the lines from high on are not
+  const char *low = dataBegin;
+  const char *high = dataEnd;
+  while (low < high)
+  {
+    // find the start of the line that contains the middle
+    const char *line = low + (high - low) / 2;
+    while (line > low && line[-1] != '\n')
+    {
+      --line;
+    }
+    int year;
+    int lineDate;
+    if (readLineDate(line, dataEnd, year, lineDate) != 0)
+    {
+      return NULL;
+    }
+    if (lineDate < date)
+    {
+      const char *newline = (const char *)memchr(line, '\n', dataEnd - line);
+      low = newline ? newline + 1 : dataEnd;
+    }
+    else
+    {
+      high = line;
+    }
+  }
+  return low;
+}
+
+// convert only the lines of the dates to output by seeking to them
+// the lines of data are found with binary searches on their dates so the time that this takes
+// depends on the number of days that are output and not on the size of the epw file
+// this can only be done when the lines are in the order of their dates so it checks
+// that the data is for one year that is in order from the first to the last line
+// the lines outside of the dates are not read so a problem in them is not found
+// return 0 if the data was converted, -1 if a line could not be processed
+// and 1 if the data can't be searched and needs to be converted line by line
+static int convertDataSeek(const epwHeaderStruct &header, const char *epwEnd, wthWriter &writer,
+  int startDate, int endDate, conversionStatsStruct *stats, conversionErrorStruct &error)
+{
+  const char *dataBegin = header.dataBegin;
+  if (header.startDate > header.endDate)
+  {
+    // the data period wraps around the end of the year
+    return 1;
+  }
+
+  // leave out the newlines at the end of the file
+  const char *dataEnd = epwEnd;
+  while (dataEnd > dataBegin && (dataEnd[-1] == '\n' || dataEnd[-1] == '\r'))
+  {
+    --dataEnd;
+  }
+  if (dataEnd == dataBegin)
+  {
+    return 1;
+  }
+  const char *lastLine = dataEnd;
+  while (lastLine > dataBegin && lastLine[-1] != '\n')
+  {
+    --lastLine;
+  }
+  int firstYear;
+  int firstDate;
+  int lastYear;
+  int lastDate;
+  if (readLineDate(dataBegin, dataEnd, firstYear, firstDate) != 0 ||
+    readLineDate(lastLine, dataEnd, lastYear, lastDate) != 0 ||
+    firstYear != lastYear || firstDate > lastDate)
+  {
+    return 1;
+  }
+
+  // find the lines of the dates, there are two ranges of lines when the dates wrap around the year
+  // and then the lines at the start of the year come first in the file
+  const char *ranges[2][2];
+  int rangeCount;
+  if (startDate <= endDate)
+  {
+    ranges[0][0] = findFirstLineOfDate(dataBegin, dataEnd, startDate);
+    ranges[0][1] = findFirstLineOfDate(dataBegin, dataEnd, endDate + 1);
+    rangeCount = 1;
+  }
+  else
   {
-    // output the same data but with time == 0 since CONTAM requires the first line to be time == 0
-    ostream << IntDateXToStringDateX(doy) << '\t' << IntTimeToStringTime(0) << '\t'
-      << dryBulbTemperatureK << '\t' << barometricPressure << '\t'
-      << windSpeed << '\t' << windDirection << '\t' << humidityRaito << '\t'
-      << totalHorizontalSolarRadiation2 << '\t' << directNormalSolarRadiation2 << '\t'
-      << skyRadiantTemprerature << '\t' << rain << '\t' << snow << std::endl;
+    ranges[0][0] = dataBegin;
+    ranges[0][1] = findFirstLineOfDate(dataBegin, dataEnd, endDate + 1);
+    ranges[1][0] = findFirstLineOfDate(dataBegin, dataEnd, startDate);
+    ranges[1][1] = dataEnd;
+    rangeCount = 2;
+  }
+  for (int range = 0; range < rangeCount; ++range)
+  {
+    if (ranges[range][0] == NULL || ranges[range][1] == NULL)
+    {
+      return 1;
+    }
   }
 
-  // write data to wth file
-  ostream << IntDateXToStringDateX(doy) << '\t' << IntTimeToStringTime(time) << '\t'
-    << dryBulbTemperatureK << '\t' << barometricPressure << '\t'
-    << windSpeed << '\t' << windDirection << '\t' << humidityRaito << '\t'
-    << totalHorizontalSolarRadiation2 << '\t' << directNormalSolarRadiation2 << '\t'
-    << skyRadiantTemprerature << '\t' << rain << '\t' << snow << std::endl;
-  // a record has been output
-  firstRecord = false;
+  bool hasRecord = false;
+  for (int range = 0; range < rangeCount; ++range)
+  {
+    dataChunkStruct chunk;
+    chunk.stats = stats;
+    chunk.begin = ranges[range][0];
+    chunk.end = ranges[range][1];
+    convertDataLines(chunk, startDate, endDate, writer, !hasRecord);
+    hasRecord = hasRecord || chunk.hasRecord;
+    if (chunk.retVal != 0)
+    {
+      // count the lines that were skipped to find the line number, the data starts on line 9
+      int skippedLines = (int)std::count(dataBegin, chunk.begin, '\n');
+      setLineError(error, 9 + skippedLines + chunk.lineCount, chunk.errField, chunk.errMsg);
+      return -1;
+    }
+  }
 
+  // the lines that were jumped over are outside of the dates, they are only counted when they are measured
+  if (stats)
+  {
+    // the ranges start at the start of a line so the lines before them end with a newline,
+    // the last line of the data has none
+    if (rangeCount == 1)
+    {
+      stats->rowsSkipped += std::count(dataBegin, ranges[0][0], '\n');
+      if (ranges[0][1] < dataEnd)
+      {
+        stats->rowsSkipped += std::count(ranges[0][1], dataEnd, '\n') + 1;
+      }
+    }
+    else
+    {
+      stats->rowsSkipped += std::count(ranges[0][1], ranges[1][0], '\n');
+    }
+  }
+  return 0;
 }
 
 // convert an EPW file to a CONTAM Weather file
@@ -266,70 +686,118 @@ void processDataLine(std::vector<std::string> &lineItems, std::ostream &ostream,
 // istream - a stream that contains the epw file
 // ostream - the stream where the CONTAM weather file will be output
 // both streams are assumed to be opened
+// this is used when the epw file cannot be mapped into memory (e.g. a pipe)
+// errors are written to std::cerr
 int convertEPW(configStruct config, std::istream &istream, std::ostream &ostream)
 {
-  std::string line;
+  // read the whole stream so it can be converted from memory
+  std::string epwContents = std::string(std::istreambuf_iterator<char>(istream), {});
+  return convertEPW(config, epwContents.data(), epwContents.data() + epwContents.length(), ostream);
+}
+
+// convert an EPW file to a CONTAM Weather file
+// errors are written to std::cerr
+int convertEPW(configStruct config, const char *epwBegin, const char *epwEnd, std::ostream &ostream)
+{
+  std::string errMsg;
+  int retVal = convertEPW(config, epwBegin, epwEnd, ostream, errMsg);
+  if (retVal != 0)
+  {
+    std::cerr << errMsg << std::endl;
+  }
+  return retVal;
+}
+
+// read the header section of an epw file
+// epwBegin - the first byte of the epw file
+// epwEnd - one past the last byte of the epw file
+// header - receives the data from the header that is used for the weather file
+// errField - receives the field of line 8 (1 based) with the problem if the header is not valid
+// errMsg - receives a description of the problem if the header is not valid
+// return 0 if the header was read and -1 if it is not valid
+int readEPWHeader(const char *epwBegin, const char *epwEnd, epwHeaderStruct &header, int &errField,
+  std::string &errMsg)
+{
+  const char *cursor = epwBegin;
+  std::string_view line;
   std::vector<std::string> lineItems;
-  std::string epwDescription;
 
   // get line 1 location data
   // use it as the default description for the weather file
-  std::getline(istream, line);
+  cursor = getLine(cursor, epwEnd, line);
   // truncate since description is limited to 256 chars in CONTAM weather files
-  epwDescription = line.substr(0, 256);
-
-  // get line 2 conditions
-  std::getline(istream, line);
-
-  // get line 3 preiods
-  std::getline(istream, line);
-
-  // get line 4 ground temps
-  std::getline(istream, line);
+  header.description = std::string(line.substr(0, 256));
 
-  // get line 5 holidays
-  std::getline(istream, line);
-
-  // get line 6 comments #1
-  std::getline(istream, line);
-
-  // get line 7 comments #2
-  std::getline(istream, line);
+  // skip line 2 conditions, line 3 periods, line 4 ground temps
+  // line 5 holidays, line 6 comments #1 and line 7 comments #2
+  for (int headerLine = 2; headerLine <= 7; ++headerLine)
+  {
+    cursor = getLine(cursor, epwEnd, line);
+  }
 
   // get line 8 data periods
-  std::getline(istream, line);
+  cursor = getLine(cursor, epwEnd, line);
 
   // split the line by comma
-  split(line, ',', lineItems);
+  split(std::string(line), ',', lineItems);
+  if (lineItems.size() < 7)
+  {
+    errField = (int)lineItems.size() + 1;
+    errMsg = "Invalid data periods in the epw file: " + std::string(line);
+    return -1;
+  }
+
+  // the number of records per hour is only checked by validateEPW
+  if (parseEPWInt(lineItems[2], header.recordsPerHour) != 0)
+  {
+    header.recordsPerHour = 0;
+  }
 
   // get the start and end dates for the EPW file
   std::string epwStartDateString = lineItems[5];
   std::string epwEndDateString = lineItems[6];
-  int epwStartDate = StringDateXToIntDateX(epwStartDateString);
-  if (epwStartDate == -1)
+  header.startDate = StringDateXToIntDateX(epwStartDateString);
+  if (header.startDate == -1)
   {
-    std::cerr << "Invalid start date in the epw file: " << epwStartDateString << std::endl;
+    errField = 6;
+    errMsg = "Invalid start date in the epw file: " + epwStartDateString;
     return -1;
   }
-  int epwEndDate = StringDateXToIntDateX(epwEndDateString);
-  if (epwEndDate == -1)
+  header.endDate = StringDateXToIntDateX(epwEndDateString);
+  if (header.endDate == -1)
   {
-    std::cerr << "Invalid end date in the epw file: " << epwEndDate << std::endl;
+    errField = 7;
+    errMsg = "Invalid end date in the epw file: " + epwEndDateString;
     return -1;
   }
 
+  header.dataBegin = cursor;
+  return 0;
+}
+
+// check the dates of a config against an epw file and write the head section of the weather file
+// config - a struct representation of the config file
+// header - the header of the epw file
+// writer - writes the weather file
+// startDate - receives the date to start outputing data
+// endDate - receives the date to end outputing data
+// errMsg - receives a description of the problem if the config does not fit the epw file
+// return 0 if the head section was written and -1 if the config does not fit the epw file
+int writeWthHead(const configStruct &config, const epwHeaderStruct &header, wthWriter &writer,
+  int &startDate, int &endDate, std::string &errMsg)
+{
   //check if a config was given
   if (config.startDate > -1 && config.endDate > -1)
   {
     //ensure that the config start and end dates are found in the EPW file
-    if (!dateIsWithinRange(config.startDate, epwStartDate, epwEndDate))
+    if (!dateIsWithinRange(config.startDate, header.startDate, header.endDate))
     {
-      std::cerr << "The start date in config is not within the dates included in the EPW file." << std::endl;
+      errMsg = "The start date in config is not within the dates included in the EPW file.";
       return -1;
     }
-    if (!dateIsWithinRange(config.endDate, epwStartDate, epwEndDate))
+    if (!dateIsWithinRange(config.endDate, header.startDate, header.endDate))
     {
-      std::cerr << "The end date in config is not within the dates included in the EPW file." << std::endl;
+      errMsg = "The end date in config is not within the dates included in the EPW file.";
       return -1;
     }
   }
@@ -339,25 +807,23 @@ int convertEPW(configStruct config, std::istream &istream, std::ostream &ostream
   // otherwise use the first line of the epw file
   std::string description;
   if (config.descr.length() == 0)
-    description = epwDescription;
+    description = header.description;
   else
     description = config.descr;
 
   //determine the start and end dates
   // if the config has -1 for the dates then use the EPW date
-  int startDate;
   if (config.startDate == -1)
   {
-    startDate = epwStartDate;
+    startDate = header.startDate;
   }
   else
   {
     startDate = config.startDate;
   }
-  int endDate;
   if (config.endDate == -1)
   {
-    endDate = epwEndDate;
+    endDate = header.endDate;
   }
   else
   {
@@ -365,48 +831,588 @@ int convertEPW(configStruct config, std::istream &istream, std::ostream &ostream
   }
 
   //write weather file head section
-  ostream << "WeatherFile ContamW 2.0" << std::endl
-    << description << std::endl
-    << IntDateXToStringDateX(startDate) << " !start - of - file date" << std::endl
-    << IntDateXToStringDateX(endDate) << " !end - of - file date" << std::endl
-    << "!Date" << '\t' << "DofW" << '\t' << "Dtype" << '\t'
-    << "DST" << '\t' << "Tgrnd [K]" << std::endl;
+  writer.writeText("WeatherFile ContamW 2.0\n");
+  writer.writeText(description);
+  writer.writeText("\n");
+  writer.writeText(dateLabel(startDate));
+  writer.writeText(" !start - of - file date\n");
+  writer.writeText(dateLabel(endDate));
+  writer.writeText(" !end - of - file date\n");
+  writer.writeText("!Date\tDofW\tDtype\tDST\tTgrnd [K]\n");
 
-  int dayType = config.firstDOY;
-  int dayOfWeek = config.firstDOY;
+  // use the calendar of the config if it was compiled for the same start date
+  // a config without one (e.g. the default config) starts on the date of the epw file
+  dayCalendarStruct localCalendar;
+  const dayCalendarStruct *calendar = config.calendar.get();
+  if (calendar == NULL || calendar->startDate != startDate)
+  {
+    compileDayCalendar(config, startDate, localCalendar);
+    calendar = &localCalendar;
+  }
 
   if (startDate <= endDate)
   {
-    outputWthHeaderDays(startDate, endDate, ostream, dayOfWeek, dayType, config);
+    outputWthHeaderDays(startDate, endDate, writer, *calendar);
   }
   else
   {
-    outputWthHeaderDays(startDate, 365, ostream, dayOfWeek, dayType, config);
-    outputWthHeaderDays(1, endDate, ostream, dayOfWeek, dayType, config);
+    outputWthHeaderDays(startDate, 365, writer, *calendar);
+    outputWthHeaderDays(1, endDate, writer, *calendar);
   }
 
   // write comment line that describes the data columns
-  ostream << "!Date" << '\t' << "Time" << '\t' << "Ta[K]" << '\t' << "Pb[Pa]" << '\t' 
-    << "Ws[m / s]" << '\t' << "Wd[deg]" << '\t' << "Hr[g / kg]" << '\t' 
-    << "Ith[kJ / m ^ 2]" << '\t' << "Idn[kJ / m ^ 2]" << '\t' << "Ts[K]" << '\t' 
-    << "Rn[-]" << '\t' << "Sn[-]" << std::endl;
+  writer.writeText("!Date\tTime\tTa[K]\tPb[Pa]\tWs[m / s]\tWd[deg]\tHr[g / kg]\t"
+    "Ith[kJ / m ^ 2]\tIdn[kJ / m ^ 2]\tTs[K]\tRn[-]\tSn[-]\n");
+
+  return 0;
+}
+
+// convert an EPW file to a CONTAM Weather file
+// config - a struct representation of the config file
+// epwBegin - the first byte of the epw file
+// epwEnd - one past the last byte of the epw file
+// ostream - the stream where the CONTAM weather file will be output
+// errMsg - receives a description of the problem if the conversion fails
+// return 0 if the conversion succeeded and -1 if it failed
+// nothing is written to the console so this can be called from several threads at once
+int convertEPW(configStruct config, const char *epwBegin, const char *epwEnd, std::ostream &ostream,
+  std::string &errMsg)
+{
+  conversionErrorStruct error;
+  int retVal = convertEPW(config, epwBegin, epwEnd, ostream, error);
+  if (retVal != 0)
+  {
+    errMsg = error.errMsg;
+  }
+  return retVal;
+}
+
+// convert a binary epw file (*.epwb) to a CONTAM Weather file
+// the records are copied from the columns of the file without parsing any text
+// config - a struct representation of the config file
+// epwBegin - the first byte of the binary epw file
+// epwEnd - one past the last byte of the binary epw file
+// ostream - the stream where the CONTAM weather file will be output
+// error - receives the kind of problem and a description of it if the conversion fails
+// return 0 if the conversion succeeded and -1 if it failed
+static int convertEPWBinary(const configStruct &config, const char *epwBegin, const char *epwEnd,
+  std::ostream &ostream, conversionErrorStruct &error)
+{
+  conversionStatsStruct *stats = config.stats;
+  double mark = stats ? statsClock() : 0;
+  epwStoreStruct store;
+  if (readEPWBinary(epwBegin, epwEnd, store, error.errMsg) != 0)
+  {
+    error.type = CONVERSION_ERROR_HEADER;
+    return -1;
+  }
+  addStageTime(stats, STAGE_READ, mark);
+
+  wthWriter writer(&ostream, config.outputPrecision);
+  writer.measure(stats);
+  writer.compress(config.compressOutput ? config.compressTolerances : NULL);
+  int startDate;
+  int endDate;
+  if (writeWthHead(config, store.header, writer, startDate, endDate, error.errMsg) != 0)
+  {
+    error.type = CONVERSION_ERROR_DATES;
+    return -1;
+  }
+  addStageTime(stats, STAGE_HEADER, mark);
+
+  double writeSeconds = 0;
+  if (stats)
+  {
+    stats->rowsRead += store.date.size();
+    for (size_t index = 0; index < store.date.size(); ++index)
+    {
+      stats->rowsSkipped += !dateIsWithinRange(store.date[index], startDate, endDate);
+    }
+    writeSeconds = stats->stageSeconds[STAGE_WRITE];
+  }
+  writeStoreRecords(store, startDate, endDate, writer);
+  addStageTime(stats, STAGE_FORMAT, mark);
+  if (stats)
+  {
+    stats->stageSeconds[STAGE_FORMAT] -= stats->stageSeconds[STAGE_WRITE] - writeSeconds;
+  }
+  return 0;
+}
 
-  // this starts true and stays true until the first record is output
-  bool firstRecord = true;
+// convert the text of an EPW file to a CONTAM Weather file
+// the arguments are the same as convertEPW below
+static int convertEPWText(const configStruct &config, const char *epwBegin, const char *epwEnd,
+  std::ostream &ostream, conversionErrorStruct &error)
+{
+  conversionStatsStruct *stats = config.stats;
+  double mark = stats ? statsClock() : 0;
+  epwHeaderStruct header;
+  if (readEPWHeader(epwBegin, epwEnd, header, error.field, error.errMsg) != 0)
+  {
+    // the data periods are on line 8
+    error.type = CONVERSION_ERROR_HEADER;
+    error.line = 8;
+    return -1;
+  }
+  const char *cursor = header.dataBegin;
 
-  // get the first line of data
-  std::getline(istream, line);
-  while (line.length() > 0)
+  // the output is collected in large blocks and written without flushing each line
+  wthWriter writer(&ostream, config.outputPrecision);
+  writer.measure(stats);
+  writer.compress(config.compressOutput ? config.compressTolerances : NULL);
+
+  int startDate;
+  int endDate;
+  if (writeWthHead(config, header, writer, startDate, endDate, error.errMsg) != 0)
   {
-    // split the line by comma
-    lineItems.clear();
-    split(line, ',', lineItems);
+    error.type = CONVERSION_ERROR_DATES;
+    return -1;
+  }
+  addStageTime(stats, STAGE_HEADER, mark);
 
-    processDataLine(lineItems, ostream, firstRecord, startDate, endDate);
+  // seek to the lines of the dates to output if asked to
+  if (config.seekDates)
+  {
+    int retVal = convertDataSeek(header, epwEnd, writer, startDate, endDate, stats, error);
+    if (retVal != 1)
+    {
+      return retVal;
+    }
+  }
 
-    // get the next line of data
-    std::getline(istream, line);
+  dataChunkStruct chunk;
+  chunk.begin = cursor;
+  chunk.end = epwEnd;
+  chunk.stats = stats;
+  // the records of the chunks are formatted before they are written so they can't be compressed
+  if (config.dataThreads != 1 && !config.compressOutput)
+  {
+    // convert the data section in chunks on several threads
+    convertDataChunks(chunk, startDate, endDate, writer, true, config.outputPrecision, config.dataThreads);
+  }
+  else
+  {
+    // convert the whole data section as one chunk
+    convertDataLines(chunk, startDate, endDate, writer, true);
+  }
+  if (chunk.retVal != 0)
+  {
+    // the data starts on line 9 of the epw file
+    setLineError(error, 9 + chunk.lineCount, chunk.errField, chunk.errMsg);
+    return -1;
   }
 
   return 0;
 }
+
+// convert an EPW file to a CONTAM Weather file
+// the epw file can also be a binary epw file, a zip archive or a gzip file
+// config - a struct representation of the config file
+//   the counters and times of the conversion are added to config.stats if it isn't NULL
+// epwBegin - the first byte of the epw file
+// epwEnd - one past the last byte of the epw file
+// ostream - the stream where the CONTAM weather file will be output
+// error - receives the kind of problem, where it is in the epw file and a description of it
+//   if the conversion fails
+// return 0 if the conversion succeeded and -1 if it failed
+// nothing is written to the console so this can be called from several threads at once
+int convertEPW(const configStruct &config, const char *epwBegin, const char *epwEnd, std::ostream &ostream,
+  conversionErrorStruct &error)
+{
+  error.type = CONVERSION_ERROR_NONE;
+  error.line = 0;
+  error.field = 0;
+  error.errMsg.clear();
+
+  conversionStatsStruct *stats = config.stats;
+  double start = stats ? statsClock() : 0;
+  double mark = start;
+  int retVal = 0;
+
+  // the epw file of a zip archive or a gzip file is extracted into memory and converted from there
+  std::string epwContents;
+  if (isEPWArchive(epwBegin, epwEnd))
+  {
+    retVal = extractEPWArchive(epwBegin, epwEnd, epwContents, error.errMsg);
+    if (retVal != 0)
+    {
+      error.type = CONVERSION_ERROR_FILE;
+    }
+    epwBegin = epwContents.data();
+    epwEnd = epwContents.data() + epwContents.length();
+    addStageTime(stats, STAGE_READ, mark);
+  }
+
+  if (retVal == 0)
+  {
+    if (stats)
+    {
+      stats->bytesIn += epwEnd - epwBegin;
+    }
+    // a binary epw file is already parsed
+    if (isEPWBinary(epwBegin, epwEnd))
+    {
+      retVal = convertEPWBinary(config, epwBegin, epwEnd, ostream, error);
+    }
+    else
+    {
+      retVal = convertEPWText(config, epwBegin, epwEnd, ostream, error);
+    }
+  }
+
+  if (stats)
+  {
+    stats->totalSeconds += statsClock() - start;
+  }
+  return retVal;
+}
+
+// start a conversion that is done a number of rows at a time
+// the header of the weather file is written and the rows of data are converted by stepEPWConversion
+// a binary epw file is converted all at once since it doesn't need to be parsed
+// each step is converted on the threads that the config asks for but the dates are never seeked,
+// the weather file is the same either way
+// config - a struct representation of the config file
+// epwBegin - the first byte of the epw file, it can also be a zip archive or a gzip file
+// epwEnd - one past the last byte of the epw file
+// ostream - the stream where the CONTAM weather file will be output
+// conversion - receives the state of the conversion
+// error - receives the kind of problem, where it is in the epw file and a description of it
+//   if the conversion fails
+// return 0 if the conversion was started and -1 if it failed
+int startEPWConversion(const configStruct &config, const char *epwBegin, const char *epwEnd,
+  std::ostream &ostream, epwConversionStruct &conversion, conversionErrorStruct &error)
+{
+  error.type = CONVERSION_ERROR_NONE;
+  error.line = 0;
+  error.field = 0;
+  error.errMsg.clear();
+
+  conversion.config = config;
+  conversion.config.seekDates = false;
+  conversion.epwContents.clear();
+  conversion.cursor = epwEnd;
+  conversion.epwEnd = epwEnd;
+  conversion.lineNumber = 0;
+  conversion.rowsDone = 0;
+  conversion.rowCount = 0;
+  conversion.hasRecord = false;
+  conversion.finished = true;
+  conversion.writer.reset();
+
+  if (isEPWArchive(epwBegin, epwEnd))
+  {
+    if (extractEPWArchive(epwBegin, epwEnd, conversion.epwContents, error.errMsg) != 0)
+    {
+      error.type = CONVERSION_ERROR_FILE;
+      return -1;
+    }
+    epwBegin = conversion.epwContents.data();
+    epwEnd = conversion.epwContents.data() + conversion.epwContents.length();
+    conversion.epwEnd = epwEnd;
+  }
+
+  if (isEPWBinary(epwBegin, epwEnd))
+  {
+    return convertEPWBinary(conversion.config, epwBegin, epwEnd, ostream, error);
+  }
+
+  epwHeaderStruct header;
+  if (readEPWHeader(epwBegin, epwEnd, header, error.field, error.errMsg) != 0)
+  {
+    // the data periods are on line 8
+    error.type = CONVERSION_ERROR_HEADER;
+    error.line = 8;
+    return -1;
+  }
+
+  conversion.writer = std::make_shared<wthWriter>(&ostream, config.outputPrecision);
+  conversion.writer->measure(config.stats);
+  conversion.writer->compress(config.compressOutput ? config.compressTolerances : NULL);
+  if (writeWthHead(conversion.config, header, *conversion.writer, conversion.startDate, conversion.endDate,
+    error.errMsg) != 0)
+  {
+    conversion.writer.reset();
+    error.type = CONVERSION_ERROR_DATES;
+    return -1;
+  }
+
+  // the data starts on line 9 of the epw file
+  conversion.cursor = header.dataBegin;
+  conversion.lineNumber = 9;
+  conversion.rowCount = (int)std::count(header.dataBegin, epwEnd, '\n');
+  if (epwEnd > header.dataBegin && epwEnd[-1] != '\n')
+  {
+    ++conversion.rowCount;
+  }
+  conversion.finished = false;
+  return 0;
+}
+
+// convert the next rows of data of a conversion from startEPWConversion
+// the weather file is flushed to the stream once the last row has been converted
+// conversion - the state of the conversion, rowsDone receives the number of rows converted so far
+// maxRows - the number of rows of data to convert in this step
+// error - receives the line and a description of the problem if a line can't be processed
+// return 1 if there are more rows to convert, 0 if the conversion has finished and -1 if it failed
+int stepEPWConversion(epwConversionStruct &conversion, int maxRows, conversionErrorStruct &error)
+{
+  if (conversion.finished)
+  {
+    return 0;
+  }
+
+  // end the step after maxRows lines
+  const char *stepEnd = conversion.cursor;
+  for (int row = 0; row < std::max(maxRows, 1) && stepEnd < conversion.epwEnd; ++row)
+  {
+    const char *newline = (const char *)memchr(stepEnd, '\n', conversion.epwEnd - stepEnd);
+    stepEnd = newline ? newline + 1 : conversion.epwEnd;
+  }
+
+  dataChunkStruct chunk;
+  chunk.begin = conversion.cursor;
+  chunk.end = stepEnd;
+  chunk.stats = conversion.config.stats;
+  // only the first record of the whole file gets a time 0 copy
+  if (conversion.config.dataThreads != 1 && !conversion.config.compressOutput)
+  {
+    convertDataChunks(chunk, conversion.startDate, conversion.endDate, *conversion.writer, !conversion.hasRecord,
+      conversion.config.outputPrecision, conversion.config.dataThreads);
+  }
+  else
+  {
+    convertDataLines(chunk, conversion.startDate, conversion.endDate, *conversion.writer, !conversion.hasRecord);
+  }
+  conversion.hasRecord = conversion.hasRecord || chunk.hasRecord;
+  if (chunk.retVal != 0)
+  {
+    setLineError(error, conversion.lineNumber + chunk.lineCount, chunk.errField, chunk.errMsg);
+    conversion.finished = true;
+    conversion.writer.reset();
+    return -1;
+  }
+  conversion.lineNumber += chunk.lineCount;
+  conversion.rowsDone += chunk.lineCount;
+  conversion.cursor = stepEnd;
+
+  if (chunk.reachedEmptyLine || conversion.cursor >= conversion.epwEnd)
+  {
+    conversion.rowsDone = conversion.rowCount;
+    conversion.finished = true;
+    conversion.writer->flush();
+    conversion.writer.reset();
+    return 0;
+  }
+  return 1;
+}
+
+// this holds the state of one weather file while convertEPWConfigs writes it
+struct fanOutStateStruct
+{
+  std::unique_ptr<wthWriter> writer; // writes the weather file
+  int startDate;                     // the date to start outputing data
+  int endDate;                       // the date to end outputing data
+  bool firstRecord;                  // true until the first record is output
+  bool active;                       // false once the weather file has failed
+};
+
+// write the records of a batch to every weather file whose dates include them
+// each record is formatted once and the text is copied to the weather files
+// that use the same precision as the first one
+void writeFanOutBatch(recordBatchStruct &batch, std::vector<wthOutputStruct> &outputs,
+  std::vector<fanOutStateStruct> &states)
+{
+  if (batch.count == 0)
+  {
+    return;
+  }
+  computeRecordBatch(batch);
+
+  int precision = outputs[0].config.outputPrecision;
+  wthWriter lineWriter(NULL, precision);
+  size_t lineEnds[RECORD_BATCH_SIZE];
+  for (int index = 0; index < batch.count; ++index)
+  {
+    lineWriter.writeRecord(batch.records[index], batch.records[index].time);
+    lineEnds[index] = lineWriter.output().length();
+  }
+  std::string_view lines = lineWriter.output();
+
+  for (size_t output = 0; output < outputs.size(); ++output)
+  {
+    fanOutStateStruct &state = states[output];
+    if (!state.active)
+    {
+      continue;
+    }
+    // the records of a compressed weather file go through its writer one by one
+    bool samePrecision = outputs[output].config.outputPrecision == precision && !outputs[output].config.compressOutput;
+    size_t lineBegin = 0;
+    for (int index = 0; index < batch.count; ++index)
+    {
+      const wthRecordStruct &record = batch.records[index];
+      if (dateIsWithinRange(record.date, state.startDate, state.endDate))
+      {
+        if (state.firstRecord)
+        {
+          state.writer->writeFirstRecord(record);
+        }
+        state.firstRecord = false;
+        if (samePrecision)
+        {
+          state.writer->writeText(lines.substr(lineBegin, lineEnds[index] - lineBegin));
+        }
+        else
+        {
+          state.writer->writeRecord(record, record.time);
+        }
+      }
+      lineBegin = lineEnds[index];
+    }
+  }
+  batch.count = 0;
+}
+
+// convert an EPW file to several CONTAM Weather files with different configs in one pass
+// each line of data is parsed and its psychrometrics are computed once
+// and then the record is written to every weather file whose dates include it
+// each weather file is the same as the one convertEPW writes for its config
+// epwBegin - the first byte of the epw file
+// epwEnd - one past the last byte of the epw file
+// outputs - the configs and the streams for the weather files, receives the result for each one
+// errMsg - receives a description of the problem if the epw header is not valid
+//   or of the first weather file that failed
+// return 0 if every weather file was written and -1 if any of them failed
+int convertEPWConfigs(const char *epwBegin, const char *epwEnd, std::vector<wthOutputStruct> &outputs,
+  std::string &errMsg)
+{
+  // the epw file of a zip archive or a gzip file is extracted into memory and converted from there
+  if (isEPWArchive(epwBegin, epwEnd))
+  {
+    std::string epwContents;
+    if (extractEPWArchive(epwBegin, epwEnd, epwContents, errMsg) != 0)
+    {
+      for (size_t output = 0; output < outputs.size(); ++output)
+      {
+        outputs[output].retVal = -1;
+        outputs[output].errMsg = errMsg;
+      }
+      return -1;
+    }
+    return convertEPWConfigs(epwContents.data(), epwContents.data() + epwContents.length(), outputs, errMsg);
+  }
+
+  // a binary epw file is already parsed so each weather file is written from its columns
+  if (isEPWBinary(epwBegin, epwEnd))
+  {
+    epwStoreStruct store;
+    if (readEPWBinary(epwBegin, epwEnd, store, errMsg) != 0)
+    {
+      for (size_t output = 0; output < outputs.size(); ++output)
+      {
+        outputs[output].retVal = -1;
+        outputs[output].errMsg = errMsg;
+      }
+      return -1;
+    }
+    int retVal = 0;
+    for (size_t output = 0; output < outputs.size(); ++output)
+    {
+      wthOutputStruct &wthOutput = outputs[output];
+      wthOutput.errMsg.clear();
+      wthOutput.retVal = convertEPWStore(wthOutput.config, store, *wthOutput.ostream, wthOutput.errMsg);
+      if (wthOutput.retVal != 0 && retVal == 0)
+      {
+        errMsg = wthOutput.errMsg;
+        retVal = -1;
+      }
+    }
+    return retVal;
+  }
+
+  epwHeaderStruct header;
+  int errField;
+  if (readEPWHeader(epwBegin, epwEnd, header, errField, errMsg) != 0)
+  {
+    for (size_t output = 0; output < outputs.size(); ++output)
+    {
+      outputs[output].retVal = -1;
+      outputs[output].errMsg = errMsg;
+    }
+    return -1;
+  }
+
+  // write the head sections
+  std::vector<fanOutStateStruct> states(outputs.size());
+  int activeCount = 0;
+  for (size_t output = 0; output < outputs.size(); ++output)
+  {
+    wthOutputStruct &wthOutput = outputs[output];
+    fanOutStateStruct &state = states[output];
+    state.writer.reset(new wthWriter(wthOutput.ostream, wthOutput.config.outputPrecision));
+    state.writer->compress(wthOutput.config.compressOutput ? wthOutput.config.compressTolerances : NULL);
+    state.firstRecord = true;
+    wthOutput.errMsg.clear();
+    wthOutput.retVal = writeWthHead(wthOutput.config, header, *state.writer, state.startDate,
+      state.endDate, wthOutput.errMsg);
+    state.active = wthOutput.retVal == 0;
+    if (state.active)
+    {
+      ++activeCount;
+    }
+  }
+
+  epwRowStruct row;
+  recordBatchStruct batch;
+  batch.count = 0;
+  const char *cursor = header.dataBegin;
+  // the data starts on line 9 of the epw file
+  int lineNumber = 9;
+  // process the lines of data until the end of the file or an empty line
+  for (; activeCount > 0 && cursor < epwEnd && !lineIsEmpty(cursor, epwEnd); ++lineNumber)
+  {
+    cursor = tokenizeEPWRow(cursor, epwEnd, row);
+
+    std::string lineErrMsg;
+    int retVal = parseDataLine(row, 1, 365, batch.records[batch.count],
+      batch.dewPointK[batch.count], batch.tenthsCloudCover[batch.count], errField, lineErrMsg);
+    if (retVal == 0 && ++batch.count == RECORD_BATCH_SIZE)
+    {
+      writeFanOutBatch(batch, outputs, states);
+    }
+    else if (retVal == -1)
+    {
+      // the line only fails the weather files that would have used it
+      writeFanOutBatch(batch, outputs, states);
+      for (size_t output = 0; output < outputs.size(); ++output)
+      {
+        fanOutStateStruct &state = states[output];
+        wthRecordStruct record;
+        float dewPointTemperatureK;
+        float tenthsCloudCover;
+        if (state.active && parseDataLine(row, state.startDate, state.endDate, record,
+          dewPointTemperatureK, tenthsCloudCover, errField, lineErrMsg) == -1)
+        {
+          outputs[output].retVal = -1;
+          outputs[output].errMsg = "Line " + std::to_string(lineNumber) + ": " + lineErrMsg;
+          state.active = false;
+          --activeCount;
+        }
+      }
+    }
+  }
+  writeFanOutBatch(batch, outputs, states);
+
+  int retVal = 0;
+  for (size_t output = 0; output < outputs.size(); ++output)
+  {
+    states[output].writer->flush();
+    if (outputs[output].retVal != 0 && retVal == 0)
+    {
+      errMsg = outputs[output].errMsg;
+      retVal = -1;
+    }
+  }
+  return retVal;
+}
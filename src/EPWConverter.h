@@ -1,6 +1,124 @@
 #pragma once
 #include "config.h"
+#include "EPWTokenizer.h"
 #include <istream>
+#include <memory>
 #include <ostream>
+#include <string>
+#include <vector>
 
+// this holds one record of data for the CONTAM weather file
+struct wthRecordStruct
+{
+  int date;  // day of the year (1-365)
+  int time;  // seconds of the day (0-86400)
+  float Ta;  // dry bulb temperature [K]
+  float Pb;  // barometric pressure [Pa]
+  float Ws;  // wind speed [m/s]
+  float Wd;  // wind direction [deg]
+  float Hr;  // humidity ratio [g/kg]
+  float Ith; // total horizontal solar radiation [kJ/m^2]
+  float Idn; // direct normal solar radiation [kJ/m^2]
+  float Ts;  // sky radiant temperature [K]
+  int Rn;    // rain (0 or 1)
+  int Sn;    // snow (0 or 1)
+};
+
+// this holds the data from the header section of an epw file that is used for the weather file
+struct epwHeaderStruct
+{
+  std::string description; // the location line, the default description for the weather file
+  int startDate;           // the first day of the data period (1-365)
+  int endDate;             // the last day of the data period (1-365)
+  int recordsPerHour = 0;  // the number of records in each hour of the data period (0 if it could not be read)
+  const char *dataBegin;   // the first line of the data section
+};
+
+// this holds one of the weather files that convertEPWConfigs writes from the same epw file
+struct wthOutputStruct
+{
+  configStruct config;   // the config for the weather file
+  std::ostream *ostream; // the stream where the weather file will be output
+  int retVal;            // receives 0 if the weather file was written and -1 if it failed
+  std::string errMsg;    // receives a description of the problem if the weather file failed
+};
+
+// the kinds of problems that make a conversion fail
+enum conversionErrorType
+{
+  CONVERSION_ERROR_NONE = 0, // the conversion succeeded
+  CONVERSION_ERROR_HEADER,   // the header of the epw file is not valid
+  CONVERSION_ERROR_DATES,    // the dates of the config are not in the epw file
+  CONVERSION_ERROR_DATA,     // a line of data could not be processed
+  CONVERSION_ERROR_FILE      // a file could not be opened or written
+};
+
+// this describes why a conversion failed
+struct conversionErrorStruct
+{
+  int type;           // one of the conversionErrorType values
+  int line;           // the line of the epw file with the problem (1 based, 0 if it isn't about a line)
+  int field;          // the comma separated field of the line with the problem (1 based, 0 if unknown)
+  std::string errMsg; // a description of the problem
+};
+
+// this holds a range of lines of the data section and the result of converting them
+// the whole data section is one chunk unless it is converted on several threads
+struct dataChunkStruct
+{
+  const char *begin;           // the first line of the chunk
+  const char *end;             // one past the last line of the chunk
+  std::string output;          // the wth records for the chunk when it has its own writer
+  bool hasRecord;              // true if the chunk output at least one record
+  wthRecordStruct firstRecord; // the first record output by the chunk
+  int lineCount;               // the number of lines that were processed without an error
+  bool reachedEmptyLine;       // true if the chunk contains the empty line that ends the data
+  int retVal;                  // 0 if the chunk was converted and -1 if a line failed
+  int errField;                // the field of the line that failed
+  std::string errMsg;          // the problem with the line that failed
+  conversionStatsStruct *stats; // receives the counters and times of the chunk (NULL = not measured)
+};
+
+class wthWriter;
+
+// this holds a conversion that is done a number of rows at a time with stepEPWConversion
+// so the caller can report the progress and cancel it between the steps
+// the epw file must stay in memory until the conversion is finished
+struct epwConversionStruct
+{
+  configStruct config;               // a struct representation of the config file
+  std::string epwContents;           // the epw file when it was extracted from an archive
+  const char *cursor;                // the next line of data to convert
+  const char *epwEnd;                // the end of the epw file
+  int startDate;                     // the date to start outputing data
+  int endDate;                       // the date to end outputing data
+  int lineNumber;                    // the line of the epw file at the cursor
+  int rowsDone;                      // the number of rows of data that have been converted
+  int rowCount;                      // the number of rows of data in the epw file
+  bool hasRecord;                    // true once a record has been written
+  bool finished = true;              // true once the conversion has finished or failed (or before it starts)
+  std::shared_ptr<wthWriter> writer; // writes the weather file
+};
+
+int readEPWHeader(const char *epwBegin, const char *epwEnd, epwHeaderStruct &header, int &errField,
+  std::string &errMsg);
+int writeWthHead(const configStruct &config, const epwHeaderStruct &header, wthWriter &writer,
+  int &startDate, int &endDate, std::string &errMsg);
+int parseDataLine(const epwRowStruct &lineItems, int startDate, int endDate,
+  wthRecordStruct &record, float &dewPointTemperatureK, float &tenthsCloudCover, int &errField,
+  std::string &errMsg);
+const char *getLine(const char *cursor, const char *end, std::string_view &line);
+bool lineIsEmpty(const char *cursor, const char *end);
+void convertDataChunk(dataChunkStruct &chunk, int startDate, int endDate, int precision);
+void setLineError(conversionErrorStruct &error, int line, int field, const std::string &errMsg);
+int convertEPWConfigs(const char *epwBegin, const char *epwEnd, std::vector<wthOutputStruct> &outputs,
+  std::string &errMsg);
 int convertEPW(configStruct config, std::istream &istream, std::ostream &ostream);
+int convertEPW(configStruct config, const char *epwBegin, const char *epwEnd, std::ostream &ostream);
+int convertEPW(configStruct config, const char *epwBegin, const char *epwEnd, std::ostream &ostream,
+  std::string &errMsg);
+int convertEPW(const configStruct &config, const char *epwBegin, const char *epwEnd, std::ostream &ostream,
+  conversionErrorStruct &error);
+int startEPWConversion(const configStruct &config, const char *epwBegin, const char *epwEnd,
+  std::ostream &ostream, epwConversionStruct &conversion, conversionErrorStruct &error);
+int stepEPWConversion(epwConversionStruct &conversion, int maxRows, conversionErrorStruct &error);
@@ -0,0 +1,119 @@
+#include "EPWTokenizer.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EPW_TOKENIZER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef EPW_TOKENIZER_SSE2
+// return the index of the lowest set bit in a non-zero mask
+static inline int lowestSetBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int)index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// add a field to the row if there is still room for it
+static inline void addField(epwRowStruct &row, const char *fieldStart, const char *fieldEnd)
+{
+  if (row.fieldCount < EPW_USED_FIELDS)
+  {
+    row.fields[row.fieldCount++] = std::string_view(fieldStart, fieldEnd - fieldStart);
+  }
+}
+
+// add the last field of the row
+// a carriage return at the end of the line is not part of the field
+// and a trailing empty field is dropped the same way split() drops it
+static inline void addLastField(epwRowStruct &row, const char *fieldStart, const char *fieldEnd)
+{
+  if (fieldEnd > fieldStart && fieldEnd[-1] == '\r')
+  {
+    --fieldEnd;
+  }
+  if (fieldEnd > fieldStart)
+  {
+    addField(row, fieldStart, fieldEnd);
+  }
+}
+
+// skip the rest of a row once all of the used fields have been found
+static inline const char *skipToNextRow(const char *cursor, const char *end)
+{
+  const char *newline = (const char *)memchr(cursor, '\n', end - cursor);
+  return newline ? newline + 1 : end;
+}
+
+// split one comma delimited EPW data row into views of its fields
+// begin - the start of the row
+// end - the end of the buffer that holds the row
+// row - receives the fields of the row
+// return a pointer to the start of the next row (end if there is none)
+// the commas and newlines are found 16 bytes at a time when SSE2 is available
+const char *tokenizeEPWRow(const char *begin, const char *end, epwRowStruct &row)
+{
+  const char *fieldStart = begin;
+  const char *cursor = begin;
+  row.fieldCount = 0;
+
+#ifdef EPW_TOKENIZER_SSE2
+  const __m128i commas = _mm_set1_epi8(',');
+  const __m128i newlines = _mm_set1_epi8('\n');
+  while (end - cursor >= 16)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *)cursor);
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(block, commas), _mm_cmpeq_epi8(block, newlines)));
+    while (mask)
+    {
+      const char *delimiter = cursor + lowestSetBit(mask);
+      mask &= mask - 1;
+      if (*delimiter == '\n')
+      {
+        addLastField(row, fieldStart, delimiter);
+        return delimiter + 1;
+      }
+      addField(row, fieldStart, delimiter);
+      fieldStart = delimiter + 1;
+      if (row.fieldCount == EPW_USED_FIELDS)
+      {
+        return skipToNextRow(fieldStart, end);
+      }
+    }
+    cursor += 16;
+  }
+#endif
+
+  // handle the remaining bytes one at a time
+  for (; cursor < end; ++cursor)
+  {
+    if (*cursor == '\n')
+    {
+      addLastField(row, fieldStart, cursor);
+      return cursor + 1;
+    }
+    if (*cursor == ',')
+    {
+      addField(row, fieldStart, cursor);
+      fieldStart = cursor + 1;
+      if (row.fieldCount == EPW_USED_FIELDS)
+      {
+        return skipToNextRow(fieldStart, end);
+      }
+    }
+  }
+
+  // the row ended at the end of the buffer
+  addLastField(row, fieldStart, end);
+  return end;
+}
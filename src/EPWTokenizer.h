@@ -0,0 +1,19 @@
+#pragma once
+#include <string_view>
+
+// the number of leading fields of an EPW data row that are used by the converter
+// (year through snow depth), fields after these are never looked at
+const int EPW_USED_FIELDS = 31;
+
+// the number of fields of a complete EPW data row
+const int EPW_ROW_FIELDS = 35;
+
+// this holds the fields of one EPW data row
+// the fields are views into the buffer that was tokenized so nothing is copied
+struct epwRowStruct
+{
+  std::string_view fields[EPW_USED_FIELDS]; // the leading fields of the row
+  int fieldCount;                           // the number of fields found (at most EPW_USED_FIELDS)
+};
+
+const char *tokenizeEPWRow(const char *begin, const char *end, epwRowStruct &row);
@@ -0,0 +1,354 @@
+#include "EPWtoWTHLib.h"
+#include "EPWConverter.h"
+#include "config.h"
+#include "conversionCache.h"
+#include "utils.h"
+#include "../lib/cJSON/cJSON.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// a stream buffer that writes into a block of memory
+// a growable block is allocated with malloc and grows as needed
+// otherwise the bytes that don't fit in the block are counted but not stored
+class memoryStreambuf : public std::streambuf
+{
+public:
+  memoryStreambuf(char *buffer, size_t capacity, bool growable)
+    : buffer(buffer), capacity(capacity), length(0), growable(growable), allocFailed(false)
+  {
+  }
+
+  char *data() const { return buffer; }
+  size_t size() const { return length; }
+  bool overflowed() const { return length > capacity; }
+  bool outOfMemory() const { return allocFailed; }
+
+protected:
+  std::streamsize xsputn(const char *text, std::streamsize count) override
+  {
+    if (!append(text, (size_t)count))
+    {
+      return 0;
+    }
+    return count;
+  }
+
+  int_type overflow(int_type ch) override
+  {
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      return traits_type::not_eof(ch);
+    }
+    char c = traits_type::to_char_type(ch);
+    return append(&c, 1) ? ch : traits_type::eof();
+  }
+
+private:
+  // add bytes to the end of the block
+  // return false if a growable block could not be enlarged
+  bool append(const char *text, size_t count)
+  {
+    if (growable && length + count > capacity)
+    {
+      size_t newCapacity = capacity * 2 > length + count ? capacity * 2 : length + count;
+      char *newBuffer = (char *)realloc(buffer, newCapacity);
+      if (newBuffer == NULL)
+      {
+        allocFailed = true;
+        return false;
+      }
+      buffer = newBuffer;
+      capacity = newCapacity;
+    }
+    if (length < capacity)
+    {
+      size_t stored = capacity - length < count ? capacity - length : count;
+      memcpy(buffer + length, text, stored);
+    }
+    length += count;
+    return true;
+  }
+
+  char *buffer;     // the block of memory
+  size_t capacity;  // the size of the block
+  size_t length;    // the number of bytes that have been written, more than capacity if it overflowed
+  bool growable;    // true if the block is allocated here and grows as needed
+  bool allocFailed; // true if the block could not be enlarged
+};
+
+// fill in an error if the caller asked for one
+static int setError(EPWtoWTH_Error *error, int status, int line, int column, const std::string &message)
+{
+  if (error != NULL)
+  {
+    error->status = status;
+    error->line = line;
+    error->column = column;
+    snprintf(error->message, sizeof(error->message), "%s", message.c_str());
+  }
+  return status;
+}
+
+// read the config and the options for a conversion
+// return EPWTOWTH_OK if they are valid and the status of the problem otherwise
+static int readConfig(const char *configJSON, const EPWtoWTH_Options *options, configStruct &config,
+  EPWtoWTH_Error *error)
+{
+  if (configJSON == NULL || configJSON[0] == '\0')
+  {
+    // use the same default config as the command line
+    config.useDST = 0;
+    config.startDate = -1;
+    config.endDate = -1;
+    config.firstDOY = 1;
+  }
+  else
+  {
+    cJSON *cnfJSON = parseJSON(configJSON);
+    if (cnfJSON == NULL)
+    {
+      return setError(error, EPWTOWTH_INVALID_CONFIG, 0, 0, "The config JSON could not be parsed.");
+    }
+    config = getConfigData(cnfJSON);
+    cJSON_Delete(cnfJSON);
+    if (!config.validConfig)
+    {
+      return setError(error, EPWTOWTH_INVALID_CONFIG, 0, 0, config.errMsg);
+    }
+    if (config.endDate < config.startDate)
+    {
+      return setError(error, EPWTOWTH_INVALID_CONFIG, 0, 0, "The start date cannot be after the end date.");
+    }
+  }
+
+  if (options != NULL)
+  {
+    if (options->precision < -1 || options->precision > 9)
+    {
+      return setError(error, EPWTOWTH_INVALID_ARGUMENT, 0, 0,
+        "Invalid precision: " + std::to_string(options->precision));
+    }
+    if (options->dataThreads < 0)
+    {
+      return setError(error, EPWTOWTH_INVALID_ARGUMENT, 0, 0,
+        "Invalid number of threads: " + std::to_string(options->dataThreads));
+    }
+    config.outputPrecision = options->precision;
+    config.dataThreads = options->dataThreads;
+    if (options->cacheDirectory != NULL)
+    {
+      config.cacheDir = options->cacheDirectory;
+    }
+    config.cacheMaxBytes = options->cacheMaxBytes;
+  }
+  return EPWTOWTH_OK;
+}
+
+// convert an epw file in memory and write the weather file to a stream
+// the weather file is copied from the cache instead when the config has a cache that holds it
+// cacheKey - receives the key of the weather file if it needs to be added to the cache
+// return EPWTOWTH_OK if the weather file was written and the status of the problem otherwise
+static int convertToStream(const char *epwData, size_t epwSize, const configStruct &config,
+  std::ostream &ostream, std::string &cacheKey, EPWtoWTH_Error *error)
+{
+  if (!config.cacheDir.empty())
+  {
+    std::string wthContents;
+    std::string key = conversionCacheKey(config, epwData, epwData + epwSize);
+    if (readCachedWth(config, key, wthContents) == 0)
+    {
+      ostream.write(wthContents.data(), wthContents.length());
+      return setError(error, EPWTOWTH_OK, 0, 0, "");
+    }
+    cacheKey = key;
+  }
+
+  int status;
+  conversionErrorStruct conversionError;
+  if (convertEPW(config, epwData, epwData + epwSize, ostream, conversionError) != 0)
+  {
+    switch (conversionError.type)
+    {
+    case CONVERSION_ERROR_HEADER:
+      status = EPWTOWTH_INVALID_HEADER;
+      break;
+    case CONVERSION_ERROR_DATES:
+      status = EPWTOWTH_DATES_NOT_IN_EPW;
+      break;
+    case CONVERSION_ERROR_DATA:
+      status = EPWTOWTH_INVALID_DATA;
+      break;
+    default:
+      status = EPWTOWTH_INTERNAL_ERROR;
+      break;
+    }
+    return setError(error, status, conversionError.line, conversionError.field, conversionError.errMsg);
+  }
+  return setError(error, EPWTOWTH_OK, 0, 0, "");
+}
+
+extern "C"
+{
+  // convert an epw file in memory to a CONTAM weather file in a buffer given by the caller
+  // epwData - the contents of the epw file
+  // epwSize - the number of bytes of epwData
+  // configJSON - the contents of the config file (null terminated), NULL or "" for the default config
+  // options - the options that are not part of the config, NULL for the defaults
+  // wthBuffer - the buffer for the weather file, it is not null terminated
+  //   this can be NULL when wthCapacity is 0 to find the size that is needed
+  // wthCapacity - the size of wthBuffer
+  // wthSize - receives the size of the weather file, even when it does not fit in the buffer
+  // error - receives the details of the problem if the conversion fails, can be NULL
+  // return one of the EPWtoWTH_Status values
+  int EPWtoWTH_Convert(const char *epwData, size_t epwSize, const char *configJSON,
+    const EPWtoWTH_Options *options, char *wthBuffer, size_t wthCapacity, size_t *wthSize,
+    EPWtoWTH_Error *error)
+  {
+    if ((epwData == NULL && epwSize > 0) || (wthBuffer == NULL && wthCapacity > 0) || wthSize == NULL)
+    {
+      return setError(error, EPWTOWTH_INVALID_ARGUMENT, 0, 0, "A required argument is NULL.");
+    }
+    try
+    {
+      configStruct config;
+      int status = readConfig(configJSON, options, config, error);
+      if (status != EPWTOWTH_OK)
+      {
+        return status;
+      }
+      memoryStreambuf wthMemory(wthBuffer, wthCapacity, false);
+      std::ostream wthStream(&wthMemory);
+      std::string cacheKey;
+      status = convertToStream(epwData, epwSize, config, wthStream, cacheKey, error);
+      *wthSize = wthMemory.size();
+      if (status == EPWTOWTH_OK && wthMemory.overflowed())
+      {
+        return setError(error, EPWTOWTH_BUFFER_TOO_SMALL, 0, 0,
+          "The weather file needs " + std::to_string(wthMemory.size()) + " bytes.");
+      }
+      if (status == EPWTOWTH_OK && !cacheKey.empty())
+      {
+        storeCachedWth(config, cacheKey, wthMemory.data(), wthMemory.size());
+      }
+      return status;
+    }
+    catch (const std::bad_alloc &)
+    {
+      return setError(error, EPWTOWTH_OUT_OF_MEMORY, 0, 0, "Out of memory.");
+    }
+    catch (...)
+    {
+      return setError(error, EPWTOWTH_INTERNAL_ERROR, 0, 0, "Unexpected error.");
+    }
+  }
+
+  // convert an epw file in memory to a CONTAM weather file in a buffer allocated by the library
+  // wthData - receives the weather file, it must be released with EPWtoWTH_Free
+  //   it is null terminated but the terminator is not counted in wthSize
+  //   it receives NULL if the conversion fails
+  // the other arguments are the same as EPWtoWTH_Convert
+  // return one of the EPWtoWTH_Status values
+  int EPWtoWTH_ConvertAlloc(const char *epwData, size_t epwSize, const char *configJSON,
+    const EPWtoWTH_Options *options, char **wthData, size_t *wthSize, EPWtoWTH_Error *error)
+  {
+    if ((epwData == NULL && epwSize > 0) || wthData == NULL || wthSize == NULL)
+    {
+      return setError(error, EPWTOWTH_INVALID_ARGUMENT, 0, 0, "A required argument is NULL.");
+    }
+    *wthData = NULL;
+    *wthSize = 0;
+    // a weather file is usually about half the size of its epw file
+    size_t capacity = epwSize / 2 + 4096;
+    char *buffer = (char *)malloc(capacity);
+    if (buffer == NULL)
+    {
+      return setError(error, EPWTOWTH_OUT_OF_MEMORY, 0, 0, "Out of memory.");
+    }
+    memoryStreambuf wthMemory(buffer, capacity, true);
+    int status;
+    try
+    {
+      configStruct config;
+      status = readConfig(configJSON, options, config, error);
+      std::ostream wthStream(&wthMemory);
+      std::string cacheKey;
+      if (status == EPWTOWTH_OK)
+      {
+        status = convertToStream(epwData, epwSize, config, wthStream, cacheKey, error);
+      }
+      if (status == EPWTOWTH_OK && !wthMemory.outOfMemory() && !cacheKey.empty())
+      {
+        storeCachedWth(config, cacheKey, wthMemory.data(), wthMemory.size());
+      }
+      if (status == EPWTOWTH_OK)
+      {
+        // add the null terminator
+        wthStream.put('\0');
+      }
+    }
+    catch (const std::bad_alloc &)
+    {
+      status = setError(error, EPWTOWTH_OUT_OF_MEMORY, 0, 0, "Out of memory.");
+    }
+    catch (...)
+    {
+      status = setError(error, EPWTOWTH_INTERNAL_ERROR, 0, 0, "Unexpected error.");
+    }
+    if (status == EPWTOWTH_OK && wthMemory.outOfMemory())
+    {
+      status = setError(error, EPWTOWTH_OUT_OF_MEMORY, 0, 0, "Out of memory.");
+    }
+    if (status != EPWTOWTH_OK)
+    {
+      free(wthMemory.data());
+      return status;
+    }
+    *wthData = wthMemory.data();
+    *wthSize = wthMemory.size() - 1;
+    return EPWTOWTH_OK;
+  }
+
+  // release a weather file allocated by EPWtoWTH_ConvertAlloc
+  void EPWtoWTH_Free(char *wthData)
+  {
+    free(wthData);
+  }
+
+  // return a short description of a status code
+  const char *EPWtoWTH_StatusMessage(int status)
+  {
+    switch (status)
+    {
+    case EPWTOWTH_OK:
+      return "The weather file was written.";
+    case EPWTOWTH_INVALID_ARGUMENT:
+      return "Invalid argument.";
+    case EPWTOWTH_INVALID_CONFIG:
+      return "Invalid config.";
+    case EPWTOWTH_INVALID_HEADER:
+      return "Invalid epw header.";
+    case EPWTOWTH_DATES_NOT_IN_EPW:
+      return "The config dates are not in the epw file.";
+    case EPWTOWTH_INVALID_DATA:
+      return "Invalid epw data.";
+    case EPWTOWTH_BUFFER_TOO_SMALL:
+      return "The buffer is too small for the weather file.";
+    case EPWTOWTH_OUT_OF_MEMORY:
+      return "Out of memory.";
+    default:
+      return "Internal error.";
+    }
+  }
+
+  // return the version of the converter
+  const char *EPWtoWTH_Version(void)
+  {
+    return "2.0";
+  }
+}
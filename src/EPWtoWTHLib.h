@@ -0,0 +1,73 @@
+#pragma once
+/*
+ * C interface of the EPW to CONTAM weather file converter library
+ *
+ * the epw file and the config are passed in memory and the weather file is written to memory
+ * every function can be called from several threads at once and no exceptions leave the library
+ * the config JSON is parsed one call at a time since cJSON keeps the error of a parse in a global,
+ * a host that calls cJSON_Parse on its own threads shares that global if it links the same cJSON
+ * nothing is written to the console, problems are reported through EPWtoWTH_Error
+ */
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(EPWTOWTH_EXPORTS)
+#    define EPWTOWTH_API __declspec(dllexport)
+#  else
+#    define EPWTOWTH_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define EPWTOWTH_API __attribute__((visibility("default")))
+#else
+#  define EPWTOWTH_API
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* the status codes returned by the functions */
+enum EPWtoWTH_Status
+{
+  EPWTOWTH_OK = 0,                /* the weather file was written */
+  EPWTOWTH_INVALID_ARGUMENT = 1,  /* a required pointer is NULL */
+  EPWTOWTH_INVALID_CONFIG = 2,    /* the config JSON could not be parsed or has an invalid value */
+  EPWTOWTH_INVALID_HEADER = 3,    /* the header of the epw file is not valid */
+  EPWTOWTH_DATES_NOT_IN_EPW = 4,  /* the dates of the config are not in the epw file */
+  EPWTOWTH_INVALID_DATA = 5,      /* a line of data in the epw file could not be processed */
+  EPWTOWTH_BUFFER_TOO_SMALL = 6,  /* the weather file does not fit in the buffer that was given */
+  EPWTOWTH_OUT_OF_MEMORY = 7,     /* memory could not be allocated */
+  EPWTOWTH_INTERNAL_ERROR = 8     /* an unexpected problem */
+};
+
+/* this describes why a conversion failed */
+typedef struct EPWtoWTH_Error
+{
+  int status;         /* one of the EPWtoWTH_Status values */
+  int line;           /* the line of the epw file with the problem (1 based, 0 if it isn't about a line) */
+  int column;         /* the comma separated field of the line with the problem (1 based, 0 if unknown) */
+  char message[512];  /* a description of the problem (null terminated) */
+} EPWtoWTH_Error;
+
+/* the options that are not part of the config JSON */
+typedef struct EPWtoWTH_Options
+{
+  int precision;   /* the number of decimals for the data (0-9), -1 for 6 significant digits */
+  int dataThreads; /* the number of threads that convert the data, 0 for one per processor */
+  const char *cacheDirectory;       /* the directory of a cache of weather files, NULL for no cache */
+  unsigned long long cacheMaxBytes; /* the size limit of the cache, 0 for the default (1 GB) */
+} EPWtoWTH_Options;
+
+EPWTOWTH_API int EPWtoWTH_Convert(const char *epwData, size_t epwSize, const char *configJSON,
+  const EPWtoWTH_Options *options, char *wthBuffer, size_t wthCapacity, size_t *wthSize,
+  EPWtoWTH_Error *error);
+EPWTOWTH_API int EPWtoWTH_ConvertAlloc(const char *epwData, size_t epwSize, const char *configJSON,
+  const EPWtoWTH_Options *options, char **wthData, size_t *wthSize, EPWtoWTH_Error *error);
+EPWTOWTH_API void EPWtoWTH_Free(char *wthData);
+EPWTOWTH_API const char *EPWtoWTH_StatusMessage(int status);
+EPWTOWTH_API const char *EPWtoWTH_Version(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,593 @@
+#include "batchConverter.h"
+#include "EPWConverter.h"
+#include "mappedFile.h"
+#include "threadPool.h"
+#include "conversionCache.h"
+#include "epwStore.h"
+#include "epwBinary.h"
+#include "conversionStats.h"
+#include "conversionPipeline.h"
+#include "epwValidator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+
+// this holds the contents of an epw file that is being converted
+struct epwContentsStruct
+{
+  mappedFileStruct mapping; // the memory mapping of the file when it could be mapped
+  bool mapped;              // true if the file is memory mapped
+  std::string text;         // the contents of the file when it could not be mapped
+  const char *begin;        // the first byte of the file
+  const char *end;          // one past the last byte of the file
+};
+
+// get the contents of an epw file, it is memory mapped when possible and read as a stream otherwise
+// return 0 if the contents were read and -1 if the file could not be opened
+static int openEPWContents(const std::string &epwPath, epwContentsStruct &contents, std::string &errMsg)
+{
+  contents.mapped = mapFile(epwPath, contents.mapping) == 0;
+  if (contents.mapped)
+  {
+    contents.begin = contents.mapping.data;
+    contents.end = contents.mapping.data + contents.mapping.size;
+    return 0;
+  }
+  std::ifstream epwStream;
+  // binary mode so that a binary epw file is read as is
+  epwStream.open(epwPath, std::ios::binary);
+  if (epwStream.fail())
+  {
+    errMsg = "Failed to open the epw file: " + epwPath;
+    return -1;
+  }
+  contents.text = std::string(std::istreambuf_iterator<char>(epwStream), {});
+  contents.begin = contents.text.data();
+  contents.end = contents.text.data() + contents.text.length();
+  return 0;
+}
+
+// release the contents of an epw file
+static void closeEPWContents(epwContentsStruct &contents)
+{
+  if (contents.mapped)
+  {
+    unmapFile(contents.mapping);
+  }
+  contents.text.clear();
+}
+
+// close a weather file and check that it was written
+// a weather file that failed is removed so that a partial weather file isn't left behind
+// retVal - 0 if the weather file was converted and -1 if it failed
+// return 0 if the weather file was written and -1 if it failed
+static int closeWthFile(std::ofstream &wthStream, const std::string &wthPath, int retVal, std::string &errMsg)
+{
+  wthStream.close();
+  if (retVal == 0 && wthStream.fail())
+  {
+    errMsg = "Failed to write the wth file: " + wthPath;
+    retVal = -1;
+  }
+  // don't leave a partial weather file behind
+  if (retVal != 0)
+  {
+    std::error_code error;
+    std::filesystem::remove(wthPath, error);
+  }
+  return retVal;
+}
+
+// convert one epw file to a CONTAM weather file
+// config - the config to use for the conversion
+// epwPath - the epw file to convert, it is memory mapped when possible and read as a stream otherwise
+// wthPath - the weather file to create
+// errMsg - receives a description of the problem if the conversion fails
+// return 0 if the conversion succeeded and -1 if it failed
+int convertEPWFile(const configStruct &config, const std::string &epwPath, const std::string &wthPath,
+  std::string &errMsg)
+{
+  conversionErrorStruct error;
+  int retVal = convertEPWFile(config, epwPath, wthPath, error);
+  if (retVal != 0)
+  {
+    errMsg = error.errMsg;
+  }
+  return retVal;
+}
+
+// count a weather file that was copied from the cache in the stats
+// its rows were not read so only the records and the bytes of the weather file are counted
+// stats - the counters and times of the conversion
+// wthPath - the weather file that was copied
+// start - the time that the cache was looked in, the time since then is added to the write stage
+static void addCachedWthStats(conversionStatsStruct &stats, const std::string &wthPath, double start)
+{
+  ++stats.cachedFiles;
+  std::ifstream wthStream(wthPath, std::ios::binary);
+  std::string wthContents(std::istreambuf_iterator<char>(wthStream), {});
+  stats.bytesOut += wthContents.length();
+  // the records are the lines after the heading of the data section
+  size_t heading = wthContents.find("\n!Date\tTime\t");
+  if (heading != std::string::npos)
+  {
+    size_t records = wthContents.find('\n', heading + 1);
+    if (records != std::string::npos)
+    {
+      stats.rowsWritten += std::count(wthContents.begin() + records + 1, wthContents.end(), '\n');
+    }
+  }
+  double seconds = statsClock() - start;
+  stats.stageSeconds[STAGE_WRITE] += seconds;
+  stats.totalSeconds += seconds;
+}
+
+// convert one epw file to a CONTAM weather file with a pipeline that reads the file as a stream
+// the arguments are the same as convertEPWFile below
+static int convertEPWFilePipelined(const configStruct &config, const std::string &epwPath,
+  const std::string &wthPath, conversionErrorStruct &error)
+{
+  std::ifstream epwStream;
+  // binary mode so that a binary epw file is read as is
+  epwStream.open(epwPath, std::ios::binary);
+  if (epwStream.fail())
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    error.errMsg = "Failed to open the epw file: " + epwPath;
+    return -1;
+  }
+  std::ofstream wthStream;
+  wthStream.open(wthPath);
+  if (wthStream.fail())
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    error.errMsg = "Failed to open the wth file: " + wthPath;
+    return -1;
+  }
+
+  int retVal = convertEPWPipelined(config, epwStream, wthStream, error);
+  double start = config.stats ? statsClock() : 0;
+  if (closeWthFile(wthStream, wthPath, retVal, error.errMsg) != 0 && retVal == 0)
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    retVal = -1;
+  }
+  // closing the weather file writes the last of it
+  if (config.stats)
+  {
+    double seconds = statsClock() - start;
+    config.stats->stageSeconds[STAGE_WRITE] += seconds;
+    config.stats->totalSeconds += seconds;
+  }
+  return retVal;
+}
+
+// convert one epw file to a CONTAM weather file
+// error - receives the kind of problem, where it is in the epw file and a description of it
+//   if the conversion fails
+// the other arguments are the same as above
+// config.pipeline converts the file with convertEPWPipelined unless the cache is used,
+// which needs the whole file to find the weather file
+int convertEPWFile(const configStruct &config, const std::string &epwPath, const std::string &wthPath,
+  conversionErrorStruct &error)
+{
+  error.type = CONVERSION_ERROR_NONE;
+  error.line = 0;
+  error.field = 0;
+  if (config.pipeline && config.cacheDir.empty())
+  {
+    return convertEPWFilePipelined(config, epwPath, wthPath, error);
+  }
+  double start = config.stats ? statsClock() : 0;
+  epwContentsStruct contents;
+  if (openEPWContents(epwPath, contents, error.errMsg) != 0)
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    return -1;
+  }
+  if (config.stats)
+  {
+    double seconds = statsClock() - start;
+    config.stats->stageSeconds[STAGE_READ] += seconds;
+    config.stats->totalSeconds += seconds;
+  }
+
+  // use the weather file from the cache if the same conversion was done before
+  start = config.stats ? statsClock() : 0;
+  std::string cacheKey;
+  if (!config.cacheDir.empty())
+  {
+    cacheKey = conversionCacheKey(config, contents.begin, contents.end);
+    if (copyCachedWth(config, cacheKey, wthPath) == 0)
+    {
+      if (config.stats)
+      {
+        config.stats->bytesIn += contents.end - contents.begin;
+        addCachedWthStats(*config.stats, wthPath, start);
+      }
+      closeEPWContents(contents);
+      return 0;
+    }
+  }
+
+  std::ofstream wthStream;
+  wthStream.open(wthPath);
+  if (wthStream.fail())
+  {
+    closeEPWContents(contents);
+    error.type = CONVERSION_ERROR_FILE;
+    error.errMsg = "Failed to open the wth file: " + wthPath;
+    return -1;
+  }
+
+  int retVal = convertEPW(config, contents.begin, contents.end, wthStream, error);
+  closeEPWContents(contents);
+  start = config.stats ? statsClock() : 0;
+  if (closeWthFile(wthStream, wthPath, retVal, error.errMsg) != 0 && retVal == 0)
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    retVal = -1;
+  }
+  // closing the weather file writes the last of it
+  if (config.stats)
+  {
+    double seconds = statsClock() - start;
+    config.stats->stageSeconds[STAGE_WRITE] += seconds;
+    config.stats->totalSeconds += seconds;
+  }
+  if (retVal == 0 && !cacheKey.empty())
+  {
+    storeCachedWthFile(config, cacheKey, wthPath);
+  }
+  return retVal;
+}
+
+// compile an epw file to a binary epw file (*.epwb)
+// the binary epw file can be converted with any config without parsing the text again
+// epwPath - the epw file to compile
+// epwbPath - the binary epw file to create
+// errMsg - receives a description of the problem if the epw file can't be compiled
+// return 0 if the binary epw file was written and -1 if it could not be
+int compileEPWFile(const std::string &epwPath, const std::string &epwbPath, std::string &errMsg)
+{
+  epwContentsStruct contents;
+  if (openEPWContents(epwPath, contents, errMsg) != 0)
+  {
+    return -1;
+  }
+  epwStoreStruct store;
+  int retVal = loadEPWStore(contents.begin, contents.end, store, errMsg);
+  closeEPWContents(contents);
+  if (retVal != 0)
+  {
+    return -1;
+  }
+
+  std::ofstream epwbStream;
+  epwbStream.open(epwbPath, std::ios::binary);
+  if (epwbStream.fail())
+  {
+    errMsg = "Failed to open the binary epw file: " + epwbPath;
+    return -1;
+  }
+  retVal = writeEPWBinary(store, epwbStream, errMsg);
+  epwbStream.close();
+  if (retVal == 0 && epwbStream.fail())
+  {
+    errMsg = "Failed to write the binary epw file: " + epwbPath;
+    retVal = -1;
+  }
+  // don't leave a partial binary epw file behind
+  if (retVal != 0)
+  {
+    std::error_code error;
+    std::filesystem::remove(epwbPath, error);
+  }
+  return retVal;
+}
+
+// convert one epw file with several configs in a single pass over the epw file
+// the result of each weather file is reported and a failure does not stop the others
+// configs - the configs to use
+// epwPath - the epw file to convert
+// wthPaths - the weather file to create for each config
+// return the number of weather files that failed
+int convertEPWFileConfigs(const std::vector<configStruct> &configs, const std::string &epwPath,
+  const std::vector<std::string> &wthPaths)
+{
+  std::string errMsg;
+  epwContentsStruct contents;
+  if (openEPWContents(epwPath, contents, errMsg) != 0)
+  {
+    std::cout << "Failed: " << epwPath << ": " << errMsg << std::endl;
+    return (int)configs.size();
+  }
+
+  // the weather files that are in the cache are copied and the others are converted
+  std::vector<std::string> cacheKeys(configs.size());
+  std::vector<bool> cached(configs.size(), false);
+  std::vector<std::ofstream> wthStreams(configs.size());
+  std::vector<wthOutputStruct> outputs;
+  for (size_t index = 0; index < configs.size(); ++index)
+  {
+    if (!configs[index].cacheDir.empty())
+    {
+      cacheKeys[index] = conversionCacheKey(configs[index], contents.begin, contents.end);
+      cached[index] = copyCachedWth(configs[index], cacheKeys[index], wthPaths[index]) == 0;
+    }
+    if (!cached[index])
+    {
+      wthOutputStruct output;
+      output.config = configs[index];
+      output.ostream = &wthStreams[index];
+      outputs.push_back(output);
+      wthStreams[index].open(wthPaths[index]);
+    }
+  }
+  if (!outputs.empty())
+  {
+    convertEPWConfigs(contents.begin, contents.end, outputs, errMsg);
+  }
+  closeEPWContents(contents);
+
+  int failures = 0;
+  size_t outputIndex = 0;
+  for (size_t index = 0; index < configs.size(); ++index)
+  {
+    int retVal = 0;
+    std::string outputErrMsg;
+    if (!cached[index])
+    {
+      outputErrMsg = outputs[outputIndex].errMsg;
+      if (wthStreams[index].is_open())
+      {
+        retVal = closeWthFile(wthStreams[index], wthPaths[index], outputs[outputIndex].retVal, outputErrMsg);
+      }
+      else
+      {
+        retVal = -1;
+        outputErrMsg = "Failed to open the wth file: " + wthPaths[index];
+      }
+      if (retVal == 0 && !cacheKeys[index].empty())
+      {
+        storeCachedWthFile(configs[index], cacheKeys[index], wthPaths[index]);
+      }
+      ++outputIndex;
+    }
+    if (retVal == 0)
+    {
+      std::cout << "Converted: " << epwPath << " -> " << wthPaths[index] << std::endl;
+    }
+    else
+    {
+      ++failures;
+      std::cout << "Failed: " << wthPaths[index] << ": " << outputErrMsg << std::endl;
+    }
+  }
+
+  std::cout << "Converted " << configs.size() - failures << " of " << configs.size() << " weather files." << std::endl;
+  return failures;
+}
+
+// return true if the name matches a pattern that can contain the wildcards * and ?
+// the comparison ignores case like file names on Windows
+static bool wildcardMatch(const char *pattern, const char *name)
+{
+  const char *starPattern = NULL;
+  const char *starName = NULL;
+  while (*name)
+  {
+    if (*pattern == '*')
+    {
+      starPattern = ++pattern;
+      starName = name;
+    }
+    else if (*pattern == '?' || tolower((unsigned char)*pattern) == tolower((unsigned char)*name))
+    {
+      ++pattern;
+      ++name;
+    }
+    else if (starPattern)
+    {
+      pattern = starPattern;
+      name = ++starName;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  while (*pattern == '*')
+  {
+    ++pattern;
+  }
+  return *pattern == '\0';
+}
+
+// find the epw files for a batch conversion
+// pattern - either a directory (all of the *.epw files in it are used)
+//   or a path whose file name contains the wildcards * and ? (e.g. climate/*.epw)
+// epwPaths - the files that are found are appended in sorted order
+// errMsg - receives a description of the problem if the files can't be listed
+// return 0 if the files were listed and -1 if they could not be
+int findEPWFiles(const std::string &pattern, std::vector<std::string> &epwPaths, std::string &errMsg)
+{
+  std::filesystem::path directory;
+  std::string namePattern;
+  std::error_code error;
+  if (std::filesystem::is_directory(pattern, error))
+  {
+    directory = pattern;
+    namePattern = "*.epw";
+  }
+  else
+  {
+    std::filesystem::path path = pattern;
+    directory = path.parent_path();
+    if (directory.empty())
+    {
+      directory = ".";
+    }
+    namePattern = path.filename().generic_string();
+  }
+
+  std::vector<std::string> found;
+  std::filesystem::directory_iterator entries(directory, error);
+  if (error)
+  {
+    errMsg = "Failed to list the directory: " + directory.generic_string();
+    return -1;
+  }
+  for (const std::filesystem::directory_entry &entry : entries)
+  {
+    if (entry.is_directory(error))
+    {
+      continue;
+    }
+    if (wildcardMatch(namePattern.c_str(), entry.path().filename().generic_string().c_str()))
+    {
+      found.push_back(entry.path().generic_string());
+    }
+  }
+  std::sort(found.begin(), found.end());
+  epwPaths.insert(epwPaths.end(), found.begin(), found.end());
+  return 0;
+}
+
+// convert several epw files with the same config
+// the files are converted at the same time on a pool of threads
+// the result of each file is reported as it finishes and a failure does not stop the batch
+// config - the config to use for every file
+// files - the epw files to convert and the weather files to create
+// threadCount - the number of threads to use, 0 means one per hardware thread
+// return the number of files that failed
+int convertEPWBatch(const configStruct &config, const std::vector<batchFileStruct> &files,
+  unsigned int threadCount)
+{
+  std::mutex reportMutex;
+  int failures = 0;
+  {
+    threadPool pool(std::min<unsigned int>(threadCount ? threadCount : std::thread::hardware_concurrency(),
+      (unsigned int)files.size()));
+    for (size_t index = 0; index < files.size(); ++index)
+    {
+      const batchFileStruct &file = files[index];
+      pool.submit([&config, &file, &reportMutex, &failures]()
+      {
+        // each file is measured on its own and added to the total with the report
+        configStruct fileConfig = config;
+        conversionStatsStruct fileStats;
+        if (config.stats)
+        {
+          resetConversionStats(fileStats);
+          fileConfig.stats = &fileStats;
+        }
+        std::string errMsg;
+        int retVal = convertEPWFile(fileConfig, file.epwPath, file.wthPath, errMsg);
+
+        std::lock_guard<std::mutex> lock(reportMutex);
+        if (config.stats)
+        {
+          addConversionStats(*config.stats, fileStats);
+        }
+        if (retVal == 0)
+        {
+          std::cout << "Converted: " << file.epwPath << " -> " << file.wthPath << std::endl;
+        }
+        else
+        {
+          ++failures;
+          std::cout << "Failed: " << file.epwPath << ": " << errMsg << std::endl;
+        }
+      });
+    }
+    pool.wait();
+  }
+
+  std::cout << "Converted " << files.size() - failures << " of " << files.size() << " epw files." << std::endl;
+  return failures;
+}
+
+// validate a batch of epw files without converting them
+// the problems of each file are reported with their line and field as the file finishes
+// and every file is checked however many problems the others have
+// epwPaths - the epw files to validate
+// threadCount - the number of files to validate at once, 0 means one per hardware thread
+// return the number of files that have problems or could not be read
+int validateEPWBatch(const std::vector<std::string> &epwPaths, unsigned int threadCount)
+{
+  std::mutex reportMutex;
+  int failures = 0;
+  {
+    threadPool pool(std::min<unsigned int>(threadCount ? threadCount : std::thread::hardware_concurrency(),
+      (unsigned int)epwPaths.size()));
+    for (size_t index = 0; index < epwPaths.size(); ++index)
+    {
+      const std::string &epwPath = epwPaths[index];
+      pool.submit([&epwPath, &reportMutex, &failures]()
+      {
+        std::vector<epwProblemStruct> problems;
+        size_t rowCount = 0;
+        bool dataChecked = true;
+        epwContentsStruct contents;
+        std::string errMsg;
+        if (openEPWContents(epwPath, contents, errMsg) != 0)
+        {
+          epwProblemStruct problem;
+          problem.line = 0;
+          problem.field = 0;
+          problem.errMsg = errMsg;
+          problems.push_back(problem);
+        }
+        else
+        {
+          validateEPW(contents.begin, contents.end, problems, rowCount, dataChecked);
+          closeEPWContents(contents);
+        }
+
+        // the report of a file is written at once so the files don't mix
+        std::ostringstream report;
+        for (const epwProblemStruct &problem : problems)
+        {
+          report << epwPath;
+          if (problem.line > 0)
+          {
+            report << ":" << problem.line;
+            if (problem.field > 0)
+            {
+              report << ":" << problem.field;
+            }
+          }
+          report << ": " << problem.errMsg << "\n";
+        }
+        if (problems.empty() && !dataChecked)
+        {
+          report << "Valid format: " << epwPath << " (" << rowCount
+            << " rows, the values of a binary epw file are not checked, validate the epw file it was compiled from)\n";
+        }
+        else if (problems.empty())
+        {
+          report << "Valid: " << epwPath << " (" << rowCount << " rows)\n";
+        }
+        else
+        {
+          report << "Invalid: " << epwPath << " (" << rowCount << " rows, " << problems.size() << " problems)\n";
+        }
+
+        std::lock_guard<std::mutex> lock(reportMutex);
+        failures += problems.empty() ? 0 : 1;
+        std::cout << report.str() << std::flush;
+      });
+    }
+    pool.wait();
+  }
+
+  std::cout << "Validated " << epwPaths.size() << " epw files, " << failures << " with problems." << std::endl;
+  return failures;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "config.h"
+#include "EPWConverter.h"
+#include <string>
+#include <vector>
+
+// this holds one file of a batch conversion
+struct batchFileStruct
+{
+  std::string epwPath; // the epw file to convert
+  std::string wthPath; // the CONTAM weather file to create
+};
+
+int convertEPWFile(const configStruct &config, const std::string &epwPath, const std::string &wthPath,
+  std::string &errMsg);
+int convertEPWFile(const configStruct &config, const std::string &epwPath, const std::string &wthPath,
+  conversionErrorStruct &error);
+int convertEPWFileConfigs(const std::vector<configStruct> &configs, const std::string &epwPath,
+  const std::vector<std::string> &wthPaths);
+int compileEPWFile(const std::string &epwPath, const std::string &epwbPath, std::string &errMsg);
+int findEPWFiles(const std::string &pattern, std::vector<std::string> &epwPaths, std::string &errMsg);
+int convertEPWBatch(const configStruct &config, const std::vector<batchFileStruct> &files,
+  unsigned int threadCount);
+int validateEPWBatch(const std::vector<std::string> &epwPaths, unsigned int threadCount);
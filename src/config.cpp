@@ -1,5 +1,7 @@
 #include "config.h"
 #include "utils.h"
+#include "dayCalendar.h"
+#include <limits>
 
 // extract the config data from the JSON 
 // and return it in the config struct
@@ -98,6 +100,8 @@ configStruct getConfigData(cJSON *cnfJSON)
   }
 
   // process the special days
+  // a special day has a date or a rule such as "4th Thursday of November" or "last Monday of May"
+  // and it can have an offset in days from the rule, e.g. 1 for the day after
   const cJSON *specialDays = NULL;
   const cJSON *specialDay = NULL;
   specialDays = cJSON_GetObjectItem(cnfJSON, "specialdays");
@@ -106,16 +110,51 @@ configStruct getConfigData(cJSON *cnfJSON)
     specialDayStruct sd;
 
     std::string dateString = getStringFromJSON("date", specialDay);
-    if (dateString.empty())
+    std::string ruleString = getStringFromJSON("rule", specialDay);
+    if (!dateString.empty())
     {
-      config.errMsg = "date not found in a special day object";
-      config.validConfig = 0;
-      return config;
+      sd.date = StringDateXToIntDateX(dateString);
+      if (sd.date == -1)
+      {
+        config.errMsg = "Invalid date in the special day: " + dateString;
+        config.validConfig = 0;
+        return config;
+      }
     }
-    sd.date = StringDateXToIntDateX(dateString);
-    if (sd.date == -1)
+    else if (!ruleString.empty())
     {
-      config.errMsg = "Invalid date in the special day: " + dateString;
+      int week;
+      int weekday;
+      int month;
+      if (readSpecialDayRule(ruleString, week, weekday, month) != 0)
+      {
+        config.errMsg = "Invalid rule in the special day: " + ruleString;
+        config.validConfig = 0;
+        return config;
+      }
+      // the days of the week are the ones written in the weather file, which starts on firstDOY
+      sd.date = specialDayRuleDate(week, weekday, month, config.startDate, config.firstDOY);
+      if (sd.date == -1)
+      {
+        config.errMsg = "The rule in the special day does not fall on a date: " + ruleString;
+        config.validConfig = 0;
+        return config;
+      }
+      if (cJSON_GetObjectItem(specialDay, "offset") != NULL)
+      {
+        int offset = getIntFromJSON("offset", specialDay);
+        if (offset == std::numeric_limits<int>::max() || offset < -364 || offset > 364)
+        {
+          config.errMsg = "Invalid offset in the special day: " + ruleString;
+          config.validConfig = 0;
+          return config;
+        }
+        sd.date = (sd.date - 1 + offset + 365) % 365 + 1;
+      }
+    }
+    else
+    {
+      config.errMsg = "date not found in a special day object";
       config.validConfig = 0;
       return config;
     }
@@ -132,5 +171,10 @@ configStruct getConfigData(cJSON *cnfJSON)
     config.specialDays.push_back(sd);
   }
 
+  // compile the days once so the conversions that share the config look them up
+  std::shared_ptr<dayCalendarStruct> calendar = std::make_shared<dayCalendarStruct>();
+  compileDayCalendar(config, config.startDate, *calendar);
+  config.calendar = calendar;
+
   return config;
 }
@@ -1,8 +1,12 @@
 #pragma once
 #include "../lib/cJSON/cJSON.h"
+#include <memory>
 #include <string>
 #include <vector>
 
+struct conversionStatsStruct;
+struct dayCalendarStruct;
+
 // this holds the data for a special day
 struct specialDayStruct
 {
@@ -22,7 +26,20 @@ struct configStruct
   int firstDOY;       // indicates which day to the week is the first doy (1-7)
   int validConfig;    // this indicates if the config was processed correctly 
   std::string errMsg; // error message for when validConfig is false
-  std::vector<specialDayStruct> specialDays;
+  std::vector<specialDayStruct> specialDays; // the special days given by a rule are added with their date
+  // the days compiled by getConfigData for the start date of the config (NULL = compile them when they are written)
+  std::shared_ptr<const dayCalendarStruct> calendar;
+  // the options below are not part of the config file
+  int dataThreads = 1; // the number of threads that convert the data of one file (0 = one per hardware thread)
+  int outputPrecision = -1; // the number of decimals written for the data (-1 = 6 significant digits)
+  bool seekDates = false;   // find the lines of the dates to output with a binary search instead of reading every line
+  bool pipeline = false;    // read, convert and write the blocks of a file at the same time on separate threads
+  std::string cacheDir;     // the directory of the conversion cache (empty = no cache)
+  unsigned long long cacheMaxBytes = 0; // the size limit of the conversion cache (0 = the default)
+  conversionStatsStruct *stats = NULL;  // receives the counters and times of the conversion (NULL = not measured)
+  bool compressOutput = false; // drop the records that are close to a line between the records that are kept
+  // the tolerances of the dropped records for Ta [K], Pb [Pa], Ws [m/s], Wd [deg], Hr [g/kg], Ith and Idn [kJ/m^2] and Ts [K]
+  float compressTolerances[8] = { 0.1f, 10.0f, 0.1f, 5.0f, 0.1f, 10.0f, 10.0f, 0.1f };
 };
 
 configStruct getConfigData(cJSON *cnfJSON);
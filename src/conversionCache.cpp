@@ -0,0 +1,333 @@
+#include "conversionCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <thread>
+#include <vector>
+
+/*
+  The conversion cache is a directory of weather files.
+  Each file is named after a hash of the epw file and a hash of the normalized config
+  (<epw hash>-<config hash>.wth) so a weather file is found again without converting
+  when the same epw file is converted with the same config.
+  A file is written to a temporary name and then renamed so that several processes can share the cache.
+  The modification time of a file is updated when it is used and the files that were used least recently
+  are removed when the cache is larger than its limit.
+*/
+
+// the constants of the hash, the same as XXH64
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read64(const char *data)
+{
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static inline uint32_t read32(const char *data)
+{
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static inline uint64_t hashRound(uint64_t accumulator, uint64_t input)
+{
+  accumulator += input * PRIME2;
+  accumulator = rotateLeft(accumulator, 31);
+  return accumulator * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+{
+  accumulator ^= hashRound(0, value);
+  return accumulator * PRIME1 + PRIME4;
+}
+
+// compute a 64 bit hash of some bytes with the XXH64 algorithm
+// it reads 32 bytes per step in four independent lanes so it runs at several GB/s
+uint64_t hashBytes(const char *data, size_t length, uint64_t seed)
+{
+  const char *end = data + length;
+  uint64_t hash;
+  if (length >= 32)
+  {
+    uint64_t lane1 = seed + PRIME1 + PRIME2;
+    uint64_t lane2 = seed + PRIME2;
+    uint64_t lane3 = seed;
+    uint64_t lane4 = seed - PRIME1;
+    const char *lastStripe = end - 32;
+    do
+    {
+      lane1 = hashRound(lane1, read64(data));
+      lane2 = hashRound(lane2, read64(data + 8));
+      lane3 = hashRound(lane3, read64(data + 16));
+      lane4 = hashRound(lane4, read64(data + 24));
+      data += 32;
+    } while (data <= lastStripe);
+    hash = rotateLeft(lane1, 1) + rotateLeft(lane2, 7) + rotateLeft(lane3, 12) + rotateLeft(lane4, 18);
+    hash = mergeRound(hash, lane1);
+    hash = mergeRound(hash, lane2);
+    hash = mergeRound(hash, lane3);
+    hash = mergeRound(hash, lane4);
+  }
+  else
+  {
+    hash = seed + PRIME5;
+  }
+  hash += (uint64_t)length;
+
+  for (; data + 8 <= end; data += 8)
+  {
+    hash ^= hashRound(0, read64(data));
+    hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+  }
+  if (data + 4 <= end)
+  {
+    hash ^= (uint64_t)read32(data) * PRIME1;
+    hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+    data += 4;
+  }
+  for (; data < end; ++data)
+  {
+    hash ^= (uint64_t)(unsigned char)*data * PRIME5;
+    hash = rotateLeft(hash, 11) * PRIME1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+// return the fields of a config that change the weather file as text
+// configs that give the same weather file for an epw file give the same text
+// e.g. the DST dates are left out when DST is not used
+// and only the last day type given for a date is kept since that is the one that is used
+std::string normalizedConfig(const configStruct &config)
+{
+  std::string text = "wth2.0";
+  text += ";start=" + std::to_string(config.startDate);
+  text += ";end=" + std::to_string(config.endDate);
+  text += ";dst=" + std::to_string(config.useDST ? 1 : 0);
+  if (config.useDST)
+  {
+    text += "," + std::to_string(config.startDateDST) + "," + std::to_string(config.endDateDST);
+  }
+  text += ";firstdoy=" + std::to_string(config.firstDOY);
+  std::map<int, int> specialDays;
+  for (size_t index = 0; index < config.specialDays.size(); ++index)
+  {
+    specialDays[config.specialDays[index].date] = config.specialDays[index].dtype;
+  }
+  text += ";special=";
+  for (const std::pair<const int, int> &specialDay : specialDays)
+  {
+    text += std::to_string(specialDay.first) + ":" + std::to_string(specialDay.second) + ",";
+  }
+  text += ";precision=" + std::to_string(config.outputPrecision);
+  if (config.compressOutput)
+  {
+    text += ";compress=";
+    for (float tolerance : config.compressTolerances)
+    {
+      text += std::to_string(tolerance) + ",";
+    }
+  }
+  text += ";descr=" + config.descr;
+  return text;
+}
+
+// return the name of the cache file for an epw file and a config
+std::string conversionCacheKey(const configStruct &config, const char *epwBegin, const char *epwEnd)
+{
+  std::string configText = normalizedConfig(config);
+  char key[40];
+  snprintf(key, sizeof(key), "%016llx-%016llx",
+    (unsigned long long)hashBytes(epwBegin, epwEnd - epwBegin),
+    (unsigned long long)hashBytes(configText.data(), configText.length()));
+  return key;
+}
+
+// return the path of a cache file
+static std::filesystem::path cachePath(const configStruct &config, const std::string &key)
+{
+  return std::filesystem::path(config.cacheDir) / (key + ".wth");
+}
+
+// mark a cache file as used so that it is removed last
+static void touchCacheFile(const std::filesystem::path &path)
+{
+  std::error_code error;
+  std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+}
+
+// copy a weather file from the cache
+// config - the config of the conversion, it has the cache directory
+// key - the key from conversionCacheKey
+// wthPath - the weather file to create
+// return 0 if the weather file was in the cache and -1 if it needs to be converted
+int copyCachedWth(const configStruct &config, const std::string &key, const std::string &wthPath)
+{
+  std::filesystem::path path = cachePath(config, key);
+  std::error_code error;
+  std::filesystem::copy_file(path, wthPath, std::filesystem::copy_options::overwrite_existing, error);
+  if (error)
+  {
+    return -1;
+  }
+  touchCacheFile(path);
+  return 0;
+}
+
+// read a weather file from the cache
+// wthContents - receives the weather file
+// return 0 if the weather file was in the cache and -1 if it needs to be converted
+int readCachedWth(const configStruct &config, const std::string &key, std::string &wthContents)
+{
+  std::filesystem::path path = cachePath(config, key);
+  // the cache files are text files like the weather files that are copied into it
+  std::ifstream cacheStream(path);
+  if (cacheStream.fail())
+  {
+    return -1;
+  }
+  wthContents = std::string(std::istreambuf_iterator<char>(cacheStream), {});
+  if (cacheStream.bad())
+  {
+    return -1;
+  }
+  touchCacheFile(path);
+  return 0;
+}
+
+// return a unique name for a file that is being added to the cache
+static std::filesystem::path temporaryCachePath(const configStruct &config, const std::string &key)
+{
+  static std::atomic<unsigned int> counter(0);
+  std::string name = key + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+    "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "." +
+    std::to_string(counter++) + ".tmp";
+  return std::filesystem::path(config.cacheDir) / name;
+}
+
+// remove the least recently used weather files until the cache is within its limit
+static void trimCache(const configStruct &config)
+{
+  unsigned long long maxBytes = config.cacheMaxBytes ? config.cacheMaxBytes : DEFAULT_CACHE_MAX_BYTES;
+
+  // this holds a file of the cache
+  struct cacheFileStruct
+  {
+    std::filesystem::path path;
+    std::filesystem::file_time_type lastUse;
+    unsigned long long size;
+  };
+  std::vector<cacheFileStruct> files;
+  unsigned long long totalBytes = 0;
+  // the iterator is advanced with increment(error) since operator++ throws
+  // and a file that can't be looked at is left out
+  std::error_code error;
+  std::filesystem::directory_iterator entries(config.cacheDir, error);
+  for (; !error && entries != std::filesystem::directory_iterator(); entries.increment(error))
+  {
+    const std::filesystem::directory_entry &entry = *entries;
+    if (entry.path().extension() != ".wth")
+    {
+      continue;
+    }
+    cacheFileStruct file;
+    file.path = entry.path();
+    std::error_code sizeError;
+    std::error_code timeError;
+    file.size = entry.file_size(sizeError);
+    file.lastUse = entry.last_write_time(timeError);
+    if (!sizeError && !timeError)
+    {
+      totalBytes += file.size;
+      files.push_back(file);
+    }
+  }
+  if (totalBytes <= maxBytes)
+  {
+    return;
+  }
+
+  std::sort(files.begin(), files.end(), [](const cacheFileStruct &a, const cacheFileStruct &b)
+  {
+    return a.lastUse < b.lastUse;
+  });
+  for (size_t index = 0; index < files.size() && totalBytes > maxBytes; ++index)
+  {
+    // another process may have removed it already
+    std::filesystem::remove(files[index].path, error);
+    totalBytes -= files[index].size;
+  }
+}
+
+// move a temporary file into the cache and trim the cache
+static void addCacheFile(const configStruct &config, const std::string &key,
+  const std::filesystem::path &temporaryPath)
+{
+  std::error_code error;
+  std::filesystem::rename(temporaryPath, cachePath(config, key), error);
+  if (error)
+  {
+    std::filesystem::remove(temporaryPath, error);
+    return;
+  }
+  trimCache(config);
+}
+
+// add a weather file that was converted to the cache
+// problems with the cache are ignored since the weather file was created anyway
+// wthPath - the weather file that was created
+void storeCachedWthFile(const configStruct &config, const std::string &key, const std::string &wthPath)
+{
+  std::error_code error;
+  std::filesystem::create_directories(config.cacheDir, error);
+  std::filesystem::path temporaryPath = temporaryCachePath(config, key);
+  if (!std::filesystem::copy_file(wthPath, temporaryPath, error))
+  {
+    std::filesystem::remove(temporaryPath, error);
+    return;
+  }
+  addCacheFile(config, key, temporaryPath);
+}
+
+// add a weather file that was converted in memory to the cache
+// problems with the cache are ignored since the weather file was created anyway
+void storeCachedWth(const configStruct &config, const std::string &key, const char *wthData, size_t wthSize)
+{
+  std::error_code error;
+  std::filesystem::create_directories(config.cacheDir, error);
+  std::filesystem::path temporaryPath = temporaryCachePath(config, key);
+  std::ofstream cacheStream(temporaryPath);
+  cacheStream.write(wthData, wthSize);
+  cacheStream.close();
+  if (cacheStream.fail())
+  {
+    std::filesystem::remove(temporaryPath, error);
+    return;
+  }
+  addCacheFile(config, key, temporaryPath);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "config.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// the size of the conversion cache when no limit is given
+const unsigned long long DEFAULT_CACHE_MAX_BYTES = 1024ULL * 1024 * 1024;
+
+uint64_t hashBytes(const char *data, size_t length, uint64_t seed = 0);
+std::string normalizedConfig(const configStruct &config);
+std::string conversionCacheKey(const configStruct &config, const char *epwBegin, const char *epwEnd);
+int copyCachedWth(const configStruct &config, const std::string &key, const std::string &wthPath);
+int readCachedWth(const configStruct &config, const std::string &key, std::string &wthContents);
+void storeCachedWthFile(const configStruct &config, const std::string &key, const std::string &wthPath);
+void storeCachedWth(const configStruct &config, const std::string &key, const char *wthData, size_t wthSize);
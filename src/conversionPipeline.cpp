@@ -0,0 +1,361 @@
+#include "conversionPipeline.h"
+#include "wthWriter.h"
+#include "conversionStats.h"
+#include "epwArchive.h"
+#include "epwBinary.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a pipelined conversion of an epw file that is read from a stream
+// a reader thread reads the data section in blocks of whole lines, worker threads convert the blocks
+// and the calling thread writes them to the weather file in order, so reading, converting and writing overlap
+// the stages are joined by a ring of slots, a slot is filled by the reader, converted by one worker and
+// written by the writer before the reader can fill it again, so the memory used stays the same however
+// large the file is, the state of each slot is an atomic that only one stage sets at a time so the ring
+// needs no lock
+// the state and the number of the block in a slot are one atomic word (see slotTag) so a stage never sees
+// the state of one block with the number of another one
+
+// the number of bytes that the reader adds to a block at a time
+const size_t PIPELINE_BLOCK_SIZE = 256 * 1024;
+
+// the number of bytes that are read at a time to find the header section
+const size_t PIPELINE_HEADER_READ_SIZE = 64 * 1024;
+
+// the states of a slot of the ring
+enum pipelineSlotState
+{
+  SLOT_FREE = 0,  // the writer is done with the slot, the reader can fill it
+  SLOT_READ,      // the reader has filled the slot with a block of lines, a worker can convert it
+  SLOT_CONVERTED  // a worker has converted the block, the writer can write it
+};
+
+// the number of pipelineSlotState values
+const size_t SLOT_STATE_COUNT = 3;
+
+// return the tag of a slot that holds a block in a state
+// sequence - the number of the block (0 based)
+// state - one of the pipelineSlotState values
+static inline size_t slotTag(size_t sequence, pipelineSlotState state)
+{
+  return sequence * SLOT_STATE_COUNT + state;
+}
+
+// one block of lines in the ring that joins the stages of the pipeline
+struct pipelineSlotStruct
+{
+  std::atomic<size_t> tag;      // the number of the block in the slot and its state (see slotTag)
+  std::string text;             // the lines of the block
+  dataChunkStruct chunk;        // the result of converting the block
+  conversionStatsStruct stats;  // the counters and times of converting the block
+};
+
+// this holds the state that the stages of a pipeline share
+struct pipelineStruct
+{
+  std::vector<pipelineSlotStruct> slots; // the ring, block n goes into slot n % slots.size()
+  std::atomic<size_t> nextBlock;         // the next block for a worker to convert
+  std::atomic<size_t> blockCount;        // the number of blocks once the reader has finished (SIZE_MAX until then)
+  std::atomic<bool> stopping;            // set when the writer stops so the reader and the workers stop too
+  int startDate;                         // the date to start outputing data
+  int endDate;                           // the date to end outputing data
+  int precision;                         // the number of decimals to write for the floats
+  bool measure;                          // true to measure the counters and times of the blocks
+  std::string readErrMsg;                // the problem if the stream could not be read (set before blockCount)
+  conversionStatsStruct readStats;       // the bytes read and the time that it took
+};
+
+// wait for a stage of the pipeline without a lock
+// the thread gives up the processor while it waits and sleeps if the wait is a long one
+// ready - returns true when the wait is over
+template <typename Ready>
+static void waitUntil(Ready ready)
+{
+  for (int tries = 0; !ready(); ++tries)
+  {
+    if (tries < 64)
+    {
+      std::this_thread::yield();
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+}
+
+// the reader stage, reads the data section into the slots in order
+// each block ends at the end of a line, what follows the last line is carried to the next block
+// istream - the stream of the epw file after the part that was read with the header
+// carry - the start of the data section that was read with the header
+static void readBlocks(pipelineStruct &pipeline, std::istream &istream, std::string carry)
+{
+  conversionStatsStruct *stats = pipeline.measure ? &pipeline.readStats : NULL;
+  size_t sequence = 0;
+  bool atEnd = false;
+  while (!atEnd)
+  {
+    pipelineSlotStruct &slot = pipeline.slots[sequence % pipeline.slots.size()];
+    waitUntil([&]()
+    {
+      return slot.tag.load(std::memory_order_acquire) % SLOT_STATE_COUNT == SLOT_FREE ||
+        pipeline.stopping.load(std::memory_order_relaxed);
+    });
+    if (pipeline.stopping.load(std::memory_order_relaxed))
+    {
+      break;
+    }
+
+    double mark = stats ? statsClock() : 0;
+    // the slot's text keeps its memory from the last block it held
+    slot.text.swap(carry);
+    carry.clear();
+    size_t lastNewline = std::string::npos;
+    // read until the block holds at least one whole line
+    while (lastNewline == std::string::npos)
+    {
+      size_t length = slot.text.length();
+      slot.text.resize(length + PIPELINE_BLOCK_SIZE);
+      istream.read(&slot.text[length], PIPELINE_BLOCK_SIZE);
+      slot.text.resize(length + (size_t)istream.gcount());
+      if (stats)
+      {
+        stats->bytesIn += istream.gcount();
+      }
+      if (istream.bad())
+      {
+        pipeline.readErrMsg = "Failed to read the epw file.";
+        atEnd = true;
+        break;
+      }
+      if (istream.eof())
+      {
+        atEnd = true;
+        break;
+      }
+      lastNewline = slot.text.rfind('\n');
+    }
+    if (!atEnd)
+    {
+      carry.assign(slot.text, lastNewline + 1, std::string::npos);
+      slot.text.resize(lastNewline + 1);
+    }
+    addStageTime(stats, STAGE_READ, mark);
+    if (slot.text.empty() || !pipeline.readErrMsg.empty())
+    {
+      break;
+    }
+    slot.tag.store(slotTag(sequence, SLOT_READ), std::memory_order_release);
+    ++sequence;
+  }
+  pipeline.blockCount.store(sequence, std::memory_order_release);
+}
+
+// a worker stage, takes the next block that hasn't been taken and converts it into its slot
+// until there are no blocks left
+static void convertBlocks(pipelineStruct &pipeline)
+{
+  while (true)
+  {
+    size_t sequence = pipeline.nextBlock.fetch_add(1, std::memory_order_relaxed);
+    pipelineSlotStruct &slot = pipeline.slots[sequence % pipeline.slots.size()];
+    bool ready = false;
+    waitUntil([&]()
+    {
+      ready = slot.tag.load(std::memory_order_acquire) == slotTag(sequence, SLOT_READ);
+      return ready || pipeline.stopping.load(std::memory_order_relaxed) ||
+        sequence >= pipeline.blockCount.load(std::memory_order_acquire);
+    });
+    if (!ready)
+    {
+      return;
+    }
+
+    dataChunkStruct &chunk = slot.chunk;
+    chunk.begin = slot.text.data();
+    chunk.end = slot.text.data() + slot.text.length();
+    chunk.stats = NULL;
+    if (pipeline.measure)
+    {
+      resetConversionStats(slot.stats);
+      chunk.stats = &slot.stats;
+    }
+    convertDataChunk(chunk, pipeline.startDate, pipeline.endDate, pipeline.precision);
+    slot.tag.store(slotTag(sequence, SLOT_CONVERTED), std::memory_order_release);
+  }
+}
+
+// convert an EPW file that is read from a stream to a CONTAM Weather file with a pipeline
+// the weather file is the same as the one from convertEPW
+// archives, binary epw files, compressed output and seeking can't be done a block at a time,
+// for those the rest of the stream is read and converted with convertEPW
+// config - a struct representation of the config file
+//   dataThreads is the number of worker threads (0 = one per hardware thread)
+//   the counters and times of the conversion are added to config.stats if it isn't NULL
+// istream - the stream of the epw file (opened in binary mode)
+// ostream - the stream where the CONTAM weather file will be output
+// error - receives the kind of problem, where it is in the epw file and a description of it
+//   if the conversion fails
+// return 0 if the conversion succeeded and -1 if it failed
+int convertEPWPipelined(const configStruct &config, std::istream &istream, std::ostream &ostream,
+  conversionErrorStruct &error)
+{
+  error.type = CONVERSION_ERROR_NONE;
+  error.line = 0;
+  error.field = 0;
+  error.errMsg.clear();
+
+  conversionStatsStruct *stats = config.stats;
+  double start = stats ? statsClock() : 0;
+  double mark = start;
+
+  // read until the header section and the start of the data are in memory
+  std::string head;
+  while (std::count(head.begin(), head.end(), '\n') < 8 && istream)
+  {
+    size_t length = head.length();
+    head.resize(length + PIPELINE_HEADER_READ_SIZE);
+    istream.read(&head[length], PIPELINE_HEADER_READ_SIZE);
+    head.resize(length + (size_t)istream.gcount());
+  }
+  if (istream.bad())
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    error.errMsg = "Failed to read the epw file.";
+    return -1;
+  }
+
+  const char *headBegin = head.data();
+  const char *headEnd = head.data() + head.length();
+  if (config.compressOutput || config.seekDates || isEPWArchive(headBegin, headEnd) ||
+    isEPWBinary(headBegin, headEnd))
+  {
+    head.append(std::istreambuf_iterator<char>(istream), {});
+    if (stats)
+    {
+      double seconds = statsClock() - start;
+      stats->stageSeconds[STAGE_READ] += seconds;
+      stats->totalSeconds += seconds;
+    }
+    return convertEPW(config, head.data(), head.data() + head.length(), ostream, error);
+  }
+  addStageTime(stats, STAGE_READ, mark);
+
+  epwHeaderStruct header;
+  if (readEPWHeader(headBegin, headEnd, header, error.field, error.errMsg) != 0)
+  {
+    // the data periods are on line 8
+    error.type = CONVERSION_ERROR_HEADER;
+    error.line = 8;
+    return -1;
+  }
+
+  wthWriter writer(&ostream, config.outputPrecision);
+  writer.measure(stats);
+  pipelineStruct pipeline;
+  if (writeWthHead(config, header, writer, pipeline.startDate, pipeline.endDate, error.errMsg) != 0)
+  {
+    error.type = CONVERSION_ERROR_DATES;
+    return -1;
+  }
+  addStageTime(stats, STAGE_HEADER, mark);
+
+  // a few slots per worker so the reader and the writer don't hold the workers up
+  unsigned int workerCount = config.dataThreads > 0 ? (unsigned int)config.dataThreads :
+    std::max(1u, std::thread::hardware_concurrency());
+  pipeline.slots = std::vector<pipelineSlotStruct>(2 * workerCount + 2);
+  for (pipelineSlotStruct &slot : pipeline.slots)
+  {
+    slot.tag.store(slotTag(0, SLOT_FREE), std::memory_order_relaxed);
+  }
+  pipeline.nextBlock.store(0, std::memory_order_relaxed);
+  pipeline.blockCount.store(SIZE_MAX, std::memory_order_relaxed);
+  pipeline.stopping.store(false, std::memory_order_relaxed);
+  pipeline.precision = config.outputPrecision;
+  pipeline.measure = stats != NULL;
+  resetConversionStats(pipeline.readStats);
+  if (stats)
+  {
+    stats->bytesIn += head.length();
+  }
+
+  std::thread reader(readBlocks, std::ref(pipeline), std::ref(istream),
+    std::string(header.dataBegin, headEnd));
+  std::vector<std::thread> workers;
+  for (unsigned int index = 0; index < workerCount; ++index)
+  {
+    workers.emplace_back(convertBlocks, std::ref(pipeline));
+  }
+
+  // the writer stage, write the blocks in order
+  int retVal = 0;
+  bool hasRecord = false;
+  // the data starts on line 9 of the epw file
+  int lineNumber = 9;
+  for (size_t sequence = 0;; ++sequence)
+  {
+    pipelineSlotStruct &slot = pipeline.slots[sequence % pipeline.slots.size()];
+    bool ready = false;
+    waitUntil([&]()
+    {
+      ready = slot.tag.load(std::memory_order_acquire) == slotTag(sequence, SLOT_CONVERTED);
+      return ready || sequence >= pipeline.blockCount.load(std::memory_order_acquire);
+    });
+    if (!ready)
+    {
+      break;
+    }
+
+    dataChunkStruct &chunk = slot.chunk;
+    if (stats)
+    {
+      addConversionStats(*stats, slot.stats);
+    }
+    if (!hasRecord && chunk.hasRecord)
+    {
+      hasRecord = true;
+      writer.writeFirstRecord(chunk.firstRecord);
+    }
+    writer.writeText(chunk.output);
+    if (chunk.retVal != 0)
+    {
+      setLineError(error, lineNumber + chunk.lineCount, chunk.errField, chunk.errMsg);
+      retVal = -1;
+      break;
+    }
+    lineNumber += chunk.lineCount;
+    if (chunk.reachedEmptyLine)
+    {
+      break;
+    }
+    chunk.output.clear();
+    slot.tag.store(slotTag(sequence, SLOT_FREE), std::memory_order_release);
+  }
+
+  pipeline.stopping.store(true, std::memory_order_relaxed);
+  reader.join();
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+
+  if (retVal == 0 && !pipeline.readErrMsg.empty())
+  {
+    error.type = CONVERSION_ERROR_FILE;
+    error.errMsg = pipeline.readErrMsg;
+    retVal = -1;
+  }
+  if (stats)
+  {
+    addConversionStats(*stats, pipeline.readStats);
+    stats->totalSeconds += statsClock() - start;
+  }
+  return retVal;
+}
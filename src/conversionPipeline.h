@@ -0,0 +1,8 @@
+#pragma once
+#include "config.h"
+#include "EPWConverter.h"
+#include <istream>
+#include <ostream>
+
+int convertEPWPipelined(const configStruct &config, std::istream &istream, std::ostream &ostream,
+  conversionErrorStruct &error);
@@ -0,0 +1,604 @@
+#include "conversionServer.h"
+#include "batchConverter.h"
+#include "EPWConverter.h"
+#include "config.h"
+#include "threadPool.h"
+#include "utils.h"
+#include "../lib/cJSON/cJSON.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+#include <errno.h>
+#include <signal.h>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*
+  The server reads one job per line, each job is a JSON object with the fields:
+    id         - optional string or number that is echoed in the response
+    epw        - the path of the epw file to convert
+    epwdata    - the contents of the epw file, used instead of epw
+    config     - optional config object (the same fields as a config file) or the path of a config file
+    wth        - optional path of the weather file to create,
+                 without it the weather file is returned in the response as wthdata
+    precision  - optional number of decimals for the data (0-9)
+  a line with {"shutdown": true} stops the server once the jobs that were given have finished
+
+  the jobs run at the same time and a response line is written for each job when it finishes:
+    {"id": ..., "status": "ok", "wth": path or "wthdata": contents, "seconds": time to convert}
+    {"id": ..., "status": "failed", "error": message, "line": epw line, "column": epw field, "seconds": ...}
+*/
+
+// this holds a client of the server, the responses to its jobs are written to it
+struct serverClientStruct
+{
+  std::function<void(const std::string &)> write; // writes a line to the client
+  std::mutex mutex;                               // serializes the writes and guards pendingJobs
+  std::condition_variable jobsDone;               // signaled when the last pending job finishes
+  size_t pendingJobs = 0;                         // the jobs of the client that have not finished
+};
+
+// this holds one conversion job
+struct serverJobStruct
+{
+  std::string id;      // the id given by the client as JSON (empty if none was given)
+  std::string epwPath; // the epw file to convert
+  std::string epwData; // the contents of the epw file when they are given in the job
+  bool hasEpwData;     // true if the contents of the epw file are given in the job
+  std::string wthPath; // the weather file to create (empty to return it in the response)
+  configStruct config; // the config for the conversion
+};
+
+// append a string to a JSON document as a JSON string
+static void appendJSONString(std::string &json, const std::string &text)
+{
+  static const char hexDigits[] = "0123456789abcdef";
+  json += '"';
+  for (char c : text)
+  {
+    switch (c)
+    {
+    case '"':
+      json += "\\\"";
+      break;
+    case '\\':
+      json += "\\\\";
+      break;
+    case '\n':
+      json += "\\n";
+      break;
+    case '\r':
+      json += "\\r";
+      break;
+    case '\t':
+      json += "\\t";
+      break;
+    default:
+      if ((unsigned char)c < 0x20)
+      {
+        json += "\\u00";
+        json += hexDigits[(unsigned char)c >> 4];
+        json += hexDigits[(unsigned char)c & 0xf];
+      }
+      else
+      {
+        json += c;
+      }
+      break;
+    }
+  }
+  json += '"';
+}
+
+// start a response with the id of its job
+static std::string startResponse(const std::string &id)
+{
+  std::string response = "{\"id\":";
+  response += id.empty() ? "null" : id;
+  return response;
+}
+
+// the response for a job that could not be read
+static std::string invalidJobResponse(const std::string &id, const std::string &errMsg)
+{
+  std::string response = startResponse(id);
+  response += ",\"status\":\"failed\",\"error\":";
+  appendJSONString(response, errMsg);
+  response += "}";
+  return response;
+}
+
+// write a line to a client
+static void sendToClient(serverClientStruct &client, const std::string &line)
+{
+  std::lock_guard<std::mutex> lock(client.mutex);
+  client.write(line);
+}
+
+// read the config of a job
+// configItem - a config object, the path of a config file or NULL for the default config
+// return 0 if the config was read and -1 if it is not valid
+static int readJobConfig(const cJSON *configItem, configStruct &config, std::string &errMsg)
+{
+  if (configItem == NULL)
+  {
+    // use the same default config as the command line
+    config.useDST = 0;
+    config.startDate = -1;
+    config.endDate = -1;
+    config.firstDOY = 1;
+    return 0;
+  }
+
+  cJSON *fileJSON = NULL;
+  if (cJSON_IsString(configItem))
+  {
+    std::ifstream cnfStream(configItem->valuestring);
+    if (cnfStream.fail())
+    {
+      errMsg = "Failed to open the config file: " + std::string(configItem->valuestring);
+      return -1;
+    }
+    std::string cnfFileContents = std::string(std::istreambuf_iterator<char>(cnfStream), {});
+    fileJSON = parseJSON(cnfFileContents.c_str());
+    if (fileJSON == NULL)
+    {
+      errMsg = "The config file could not be parsed: " + std::string(configItem->valuestring);
+      return -1;
+    }
+    configItem = fileJSON;
+  }
+  else if (!cJSON_IsObject(configItem))
+  {
+    errMsg = "The config must be an object or the path of a config file.";
+    return -1;
+  }
+
+  config = getConfigData((cJSON *)configItem);
+  cJSON_Delete(fileJSON);
+  if (!config.validConfig)
+  {
+    errMsg = config.errMsg;
+    return -1;
+  }
+  if (config.endDate < config.startDate)
+  {
+    errMsg = "The start date cannot be after the end date.";
+    return -1;
+  }
+  return 0;
+}
+
+// read a job from a line of JSON
+// shutdown - set to true if the line asks the server to stop
+// return 0 if the job was read and -1 if it is not valid
+static int parseServerJob(const std::string &line, serverJobStruct &job, bool &shutdown,
+  std::string &errMsg)
+{
+  cJSON *jobJSON = parseJSON(line.c_str());
+  if (jobJSON == NULL || !cJSON_IsObject(jobJSON))
+  {
+    cJSON_Delete(jobJSON);
+    errMsg = "The job is not a JSON object.";
+    return -1;
+  }
+
+  int retVal = 0;
+  const cJSON *idItem = cJSON_GetObjectItem(jobJSON, "id");
+  if (cJSON_IsString(idItem) || cJSON_IsNumber(idItem))
+  {
+    char *idText = cJSON_PrintUnformatted(idItem);
+    if (idText != NULL)
+    {
+      job.id = idText;
+      cJSON_free(idText);
+    }
+  }
+
+  const cJSON *epwDataItem = cJSON_GetObjectItem(jobJSON, "epwdata");
+  job.hasEpwData = cJSON_IsString(epwDataItem);
+  if (job.hasEpwData)
+  {
+    job.epwData = epwDataItem->valuestring;
+  }
+  job.epwPath = getStringFromJSON("epw", jobJSON);
+  job.wthPath = getStringFromJSON("wth", jobJSON);
+
+  if (cJSON_IsTrue(cJSON_GetObjectItem(jobJSON, "shutdown")))
+  {
+    shutdown = true;
+  }
+  else if (!job.hasEpwData && job.epwPath.empty())
+  {
+    errMsg = "The job needs either epw or epwdata.";
+    retVal = -1;
+  }
+  else
+  {
+    retVal = readJobConfig(cJSON_GetObjectItem(jobJSON, "config"), job.config, errMsg);
+  }
+
+  const cJSON *precisionItem = cJSON_GetObjectItem(jobJSON, "precision");
+  if (retVal == 0 && precisionItem != NULL)
+  {
+    if (!cJSON_IsNumber(precisionItem) || precisionItem->valueint < 0 || precisionItem->valueint > 9)
+    {
+      errMsg = "Invalid precision.";
+      retVal = -1;
+    }
+    else
+    {
+      job.config.outputPrecision = precisionItem->valueint;
+    }
+  }
+
+  cJSON_Delete(jobJSON);
+  return retVal;
+}
+
+// run a conversion job and return its response
+static std::string runServerJob(const serverJobStruct &job)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  conversionErrorStruct error;
+  int retVal;
+  std::string wthData;
+  if (job.wthPath.empty())
+  {
+    // the weather file is returned in the response
+    std::ostringstream wthStream;
+    if (job.hasEpwData)
+    {
+      retVal = convertEPW(job.config, job.epwData.data(), job.epwData.data() + job.epwData.length(),
+        wthStream, error);
+    }
+    else
+    {
+      std::ifstream epwStream(job.epwPath, std::ios::binary);
+      if (epwStream.fail())
+      {
+        error.line = 0;
+        error.field = 0;
+        error.errMsg = "Failed to open the epw file: " + job.epwPath;
+        retVal = -1;
+      }
+      else
+      {
+        std::string epwContents = std::string(std::istreambuf_iterator<char>(epwStream), {});
+        retVal = convertEPW(job.config, epwContents.data(), epwContents.data() + epwContents.length(),
+          wthStream, error);
+      }
+    }
+    wthData = wthStream.str();
+  }
+  else if (job.hasEpwData)
+  {
+    std::ofstream wthStream(job.wthPath);
+    if (wthStream.fail())
+    {
+      error.line = 0;
+      error.field = 0;
+      error.errMsg = "Failed to open the wth file: " + job.wthPath;
+      retVal = -1;
+    }
+    else
+    {
+      retVal = convertEPW(job.config, job.epwData.data(), job.epwData.data() + job.epwData.length(),
+        wthStream, error);
+      wthStream.close();
+      if (retVal == 0 && wthStream.fail())
+      {
+        error.line = 0;
+        error.field = 0;
+        error.errMsg = "Failed to write the wth file: " + job.wthPath;
+        retVal = -1;
+      }
+      if (retVal != 0)
+      {
+        std::remove(job.wthPath.c_str());
+      }
+    }
+  }
+  else
+  {
+    retVal = convertEPWFile(job.config, job.epwPath, job.wthPath, error);
+  }
+
+  std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  std::string response = startResponse(job.id);
+  if (retVal == 0)
+  {
+    response += ",\"status\":\"ok\"";
+    if (job.wthPath.empty())
+    {
+      response += ",\"wthdata\":";
+      appendJSONString(response, wthData);
+    }
+    else
+    {
+      response += ",\"wth\":";
+      appendJSONString(response, job.wthPath);
+    }
+  }
+  else
+  {
+    response += ",\"status\":\"failed\",\"error\":";
+    appendJSONString(response, error.errMsg);
+    response += ",\"line\":" + std::to_string(error.line);
+    response += ",\"column\":" + std::to_string(error.field);
+  }
+  response += ",\"seconds\":" + std::to_string(seconds.count()) + "}";
+  return response;
+}
+
+// read a line from a client and start its job on the pool
+// the response is written to the client when the job finishes
+// return true if the line asks the server to stop
+static bool handleServerLine(const std::string &line, threadPool &pool,
+  const std::shared_ptr<serverClientStruct> &client)
+{
+  // skip blank lines
+  if (line.find_first_not_of(" \t\r") == std::string::npos)
+  {
+    return false;
+  }
+
+  std::shared_ptr<serverJobStruct> job = std::make_shared<serverJobStruct>();
+  bool shutdown = false;
+  std::string errMsg;
+  if (parseServerJob(line, *job, shutdown, errMsg) != 0)
+  {
+    sendToClient(*client, invalidJobResponse(job->id, errMsg));
+    return false;
+  }
+  if (shutdown)
+  {
+    return true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(client->mutex);
+    ++client->pendingJobs;
+  }
+  pool.submit([job, client]()
+  {
+    std::string response = runServerJob(*job);
+    std::lock_guard<std::mutex> lock(client->mutex);
+    client->write(response);
+    if (--client->pendingJobs == 0)
+    {
+      client->jobsDone.notify_all();
+    }
+  });
+  return false;
+}
+
+// wait until the jobs of a client have finished
+static void waitForClientJobs(serverClientStruct &client)
+{
+  std::unique_lock<std::mutex> lock(client.mutex);
+  client.jobsDone.wait(lock, [&client]() { return client.pendingJobs == 0; });
+}
+
+// run a server that reads jobs as JSON lines from a stream and writes the responses to another stream
+// it stops at the end of the input or when it is asked to and waits for the jobs that were given
+// input - the stream to read the jobs from (e.g. std::cin)
+// output - the stream to write the responses to (e.g. std::cout)
+// threadCount - the number of jobs to run at once, 0 means one per hardware thread
+// return 0
+int runJSONLinesServer(std::istream &input, std::ostream &output, unsigned int threadCount)
+{
+  threadPool pool(threadCount);
+  std::shared_ptr<serverClientStruct> client = std::make_shared<serverClientStruct>();
+  client->write = [&output](const std::string &line)
+  {
+    output << line << '\n';
+    output.flush();
+  };
+
+  std::string line;
+  while (std::getline(input, line))
+  {
+    if (handleServerLine(line, pool, client))
+    {
+      break;
+    }
+  }
+  waitForClientJobs(*client);
+  return 0;
+}
+
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+
+// write all of a buffer to a socket
+static void sendAll(int socketFd, const char *data, size_t length)
+{
+  while (length > 0)
+  {
+    ssize_t sent = send(socketFd, data, length, 0);
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      // the client went away, its responses are dropped
+      return;
+    }
+    data += sent;
+    length -= sent;
+  }
+}
+
+// this holds the state shared by the connections of the socket server
+struct socketServerStruct
+{
+  int listenFd;                           // the socket that accepts connections
+  threadPool *pool;                       // runs the jobs of every connection
+  std::mutex mutex;                       // guards the fields below
+  std::condition_variable connectionsDone; // signaled when the last connection closes
+  std::set<int> clientFds;                // the connections that are being served
+  bool stopping = false;                  // true once a client asked the server to stop
+};
+
+// read the jobs of one connection until the client closes it
+static void serveConnection(socketServerStruct &server, int clientFd)
+{
+  std::shared_ptr<serverClientStruct> client = std::make_shared<serverClientStruct>();
+  client->write = [clientFd](const std::string &line)
+  {
+    std::string message = line + "\n";
+    sendAll(clientFd, message.data(), message.length());
+  };
+
+  std::string pending;
+  char buffer[64 * 1024];
+  bool shutdown = false;
+  while (!shutdown)
+  {
+    ssize_t received = recv(clientFd, buffer, sizeof(buffer), 0);
+    if (received < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (received <= 0)
+    {
+      break;
+    }
+    pending.append(buffer, received);
+    // handle each complete line
+    size_t lineStart = 0;
+    size_t newline;
+    while (!shutdown && (newline = pending.find('\n', lineStart)) != std::string::npos)
+    {
+      shutdown = handleServerLine(pending.substr(lineStart, newline - lineStart), *server.pool, client);
+      lineStart = newline + 1;
+    }
+    pending.erase(0, lineStart);
+  }
+  if (!shutdown && !pending.empty())
+  {
+    // the last line does not need a newline
+    shutdown = handleServerLine(pending, *server.pool, client);
+  }
+  std::unique_lock<std::mutex> lock(server.mutex);
+  if (shutdown && !server.stopping)
+  {
+    server.stopping = true;
+    // wake up accept() in runSocketServer and stop reading from the other connections
+    // their jobs that were already given still finish
+    ::shutdown(server.listenFd, SHUT_RDWR);
+    for (int otherFd : server.clientFds)
+    {
+      ::shutdown(otherFd, SHUT_RD);
+    }
+  }
+  lock.unlock();
+
+  waitForClientJobs(*client);
+
+  lock.lock();
+  close(clientFd);
+  server.clientFds.erase(clientFd);
+  if (server.clientFds.empty())
+  {
+    // runSocketServer can return once this thread has exited
+    std::notify_all_at_thread_exit(server.connectionsDone, std::move(lock));
+  }
+}
+
+// run a server that accepts connections on a Unix domain socket
+// each connection sends jobs as JSON lines and receives the responses on the same connection
+// the server runs until a client asks it to stop and then waits for the jobs that were given
+// socketPath - the path of the socket, an existing socket file at the path is replaced
+// threadCount - the number of jobs to run at once, 0 means one per hardware thread
+// errMsg - receives a description of the problem if the socket can't be created
+// return 0 if the server ran and -1 if the socket could not be created
+int runSocketServer(const std::string &socketPath, unsigned int threadCount, std::string &errMsg)
+{
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socketPath.length() >= sizeof(address.sun_path))
+  {
+    errMsg = "The socket path is too long: " + socketPath;
+    return -1;
+  }
+  socketPath.copy(address.sun_path, socketPath.length());
+
+  // a client that goes away must not end the server
+  signal(SIGPIPE, SIG_IGN);
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0)
+  {
+    errMsg = "Failed to create the socket.";
+    return -1;
+  }
+  unlink(socketPath.c_str());
+  if (bind(listenFd, (sockaddr *)&address, sizeof(address)) != 0 || listen(listenFd, 64) != 0)
+  {
+    close(listenFd);
+    errMsg = "Failed to listen on the socket: " + socketPath;
+    return -1;
+  }
+
+  threadPool pool(threadCount);
+  socketServerStruct server;
+  server.listenFd = listenFd;
+  server.pool = &pool;
+  while (true)
+  {
+    int clientFd = accept(listenFd, NULL, NULL);
+    std::lock_guard<std::mutex> lock(server.mutex);
+    if (server.stopping)
+    {
+      if (clientFd >= 0)
+      {
+        close(clientFd);
+      }
+      break;
+    }
+    if (clientFd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      break;
+    }
+    server.clientFds.insert(clientFd);
+    std::thread(serveConnection, std::ref(server), clientFd).detach();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(server.mutex);
+    server.connectionsDone.wait(lock, [&server]() { return server.clientFds.empty(); });
+  }
+  close(listenFd);
+  unlink(socketPath.c_str());
+  return 0;
+}
+
+#else
+
+int runSocketServer(const std::string &socketPath, unsigned int threadCount, std::string &errMsg)
+{
+  errMsg = "The socket server is not supported on this platform, use --server with stdin instead.";
+  return -1;
+}
+
+#endif
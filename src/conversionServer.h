@@ -0,0 +1,7 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include <string>
+
+int runJSONLinesServer(std::istream &input, std::ostream &output, unsigned int threadCount);
+int runSocketServer(const std::string &socketPath, unsigned int threadCount, std::string &errMsg);
@@ -0,0 +1,94 @@
+#include "conversionStats.h"
+
+#include <cstdio>
+#include <string>
+
+// the names of the stages in the order of conversionStageType
+static const char *STAGE_NAMES[STAGE_COUNT] = { "read", "header", "tokenize", "parse", "psychrometrics",
+  "format", "write" };
+
+// set the counters and times to 0
+void resetConversionStats(conversionStatsStruct &stats)
+{
+  stats.rowsRead = 0;
+  stats.rowsSkipped = 0;
+  stats.rowsWritten = 0;
+  stats.cachedFiles = 0;
+  stats.bytesIn = 0;
+  stats.bytesOut = 0;
+  for (int stage = 0; stage < STAGE_COUNT; ++stage)
+  {
+    stats.stageSeconds[stage] = 0;
+  }
+  stats.totalSeconds = 0;
+}
+
+// add the counters and times of one conversion to a total
+void addConversionStats(conversionStatsStruct &total, const conversionStatsStruct &stats)
+{
+  total.rowsRead += stats.rowsRead;
+  total.rowsSkipped += stats.rowsSkipped;
+  total.rowsWritten += stats.rowsWritten;
+  total.cachedFiles += stats.cachedFiles;
+  total.bytesIn += stats.bytesIn;
+  total.bytesOut += stats.bytesOut;
+  for (int stage = 0; stage < STAGE_COUNT; ++stage)
+  {
+    total.stageSeconds[stage] += stats.stageSeconds[stage];
+  }
+  total.totalSeconds += stats.totalSeconds;
+}
+
+// describe the counters and times for a person
+std::string conversionStatsText(const conversionStatsStruct &stats)
+{
+  char line[256];
+  std::string text;
+  snprintf(line, sizeof(line), "rows read: %llu, skipped by date: %llu, written: %llu\n",
+    stats.rowsRead, stats.rowsSkipped, stats.rowsWritten);
+  text += line;
+  if (stats.cachedFiles > 0)
+  {
+    snprintf(line, sizeof(line), "weather files from the cache: %llu (their rows were not read)\n",
+      stats.cachedFiles);
+    text += line;
+  }
+  snprintf(line, sizeof(line), "bytes in: %llu, out: %llu\n", stats.bytesIn, stats.bytesOut);
+  text += line;
+  for (int stage = 0; stage < STAGE_COUNT; ++stage)
+  {
+    double share = stats.totalSeconds > 0 ? 100 * stats.stageSeconds[stage] / stats.totalSeconds : 0;
+    snprintf(line, sizeof(line), "%-15s %10.3f ms %6.1f%%\n", STAGE_NAMES[stage],
+      stats.stageSeconds[stage] * 1e3, share);
+    text += line;
+  }
+  snprintf(line, sizeof(line), "%-15s %10.3f ms", "total", stats.totalSeconds * 1e3);
+  text += line;
+  if (stats.totalSeconds > 0)
+  {
+    snprintf(line, sizeof(line), ", %.0f rows/s, %.1f MB/s", stats.rowsRead / stats.totalSeconds,
+      stats.bytesIn / stats.totalSeconds / 1e6);
+    text += line;
+  }
+  return text + "\n";
+}
+
+// describe the counters and times as a JSON object on one line
+std::string conversionStatsJSON(const conversionStatsStruct &stats)
+{
+  char field[128];
+  std::string json = "{";
+  snprintf(field, sizeof(field), "\"rowsRead\":%llu,\"rowsSkipped\":%llu,\"rowsWritten\":%llu,\"cachedFiles\":%llu,",
+    stats.rowsRead, stats.rowsSkipped, stats.rowsWritten, stats.cachedFiles);
+  json += field;
+  snprintf(field, sizeof(field), "\"bytesIn\":%llu,\"bytesOut\":%llu,\"seconds\":{", stats.bytesIn,
+    stats.bytesOut);
+  json += field;
+  for (int stage = 0; stage < STAGE_COUNT; ++stage)
+  {
+    snprintf(field, sizeof(field), "\"%s\":%.6f,", STAGE_NAMES[stage], stats.stageSeconds[stage]);
+    json += field;
+  }
+  snprintf(field, sizeof(field), "\"total\":%.6f}}", stats.totalSeconds);
+  return json + field;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+// the stages of a conversion that are timed
+enum conversionStageType
+{
+  STAGE_READ = 0,        // opening the epw file and extracting it from an archive
+  STAGE_HEADER,          // reading the header and writing the head section of the weather file
+  STAGE_TOKENIZE,        // finding the fields of the lines of data
+  STAGE_PARSE,           // converting the fields to numbers and records
+  STAGE_PSYCHROMETRICS,  // computing the humidity ratio and sky temperature
+  STAGE_FORMAT,          // formatting the records as text
+  STAGE_WRITE,           // writing the text to the weather file
+  STAGE_COUNT
+};
+
+// this holds the counters and times of a conversion
+// a conversion only measures them when its config points to one of these
+// when the data is converted on several threads the stage times are added up over the threads
+struct conversionStatsStruct
+{
+  unsigned long long rowsRead;        // the lines of data that were read
+  unsigned long long rowsSkipped;     // the lines of data that were outside of the dates (--seek counts the ones it jumped over)
+  unsigned long long rowsWritten;     // the records written to the weather file
+  unsigned long long cachedFiles;     // the weather files copied from the cache, their records are counted but no rows are read
+  unsigned long long bytesIn;         // the size of the epw file
+  unsigned long long bytesOut;        // the size of the weather file
+  double stageSeconds[STAGE_COUNT];   // the time spent in each stage
+  double totalSeconds;                // the time of the whole conversion
+};
+
+// the time in seconds from an arbitrary start, for timing the stages
+inline double statsClock()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// add the time since a mark to a stage and move the mark to now
+// nothing is done when stats is NULL so this costs nothing when a conversion isn't measured
+inline void addStageTime(conversionStatsStruct *stats, int stage, double &mark)
+{
+  if (stats)
+  {
+    double now = statsClock();
+    stats->stageSeconds[stage] += now - mark;
+    mark = now;
+  }
+}
+
+void resetConversionStats(conversionStatsStruct &stats);
+void addConversionStats(conversionStatsStruct &total, const conversionStatsStruct &stats);
+std::string conversionStatsText(const conversionStatsStruct &stats);
+std::string conversionStatsJSON(const conversionStatsStruct &stats);
@@ -0,0 +1,112 @@
+#pragma once
+#include <string_view>
+
+// lookup tables for the date and time labels of the weather file
+// the tables are generated at compile time so the labels can be copied
+// straight into the output without formatting them for each record
+
+// start of month - 1 (day-of-year)
+inline constexpr int START_OF_MONTH[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+// length of month - no leap year
+inline constexpr int LENGTH_OF_MONTH[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+// the number of minutes in a day, the time labels go from 00:00:00 to 24:00:00
+const int MINUTES_PER_DAY = 1440;
+
+// this holds the text of a date label (M/D) or a time label (HH:MM:SS)
+struct labelStruct
+{
+  char text[8];
+  int length;
+};
+
+// the date labels for the days of the year (1-365), index 0 is empty
+struct dateLabelTableStruct
+{
+  labelStruct labels[366];
+};
+
+// the time labels for each minute of the day (0-1440)
+struct timeLabelTableStruct
+{
+  labelStruct labels[MINUTES_PER_DAY + 1];
+};
+
+// append a number without leading zeros to a label
+constexpr void appendNumber(labelStruct &label, int number)
+{
+  if (number >= 10)
+  {
+    label.text[label.length++] = (char)('0' + number / 10);
+  }
+  label.text[label.length++] = (char)('0' + number % 10);
+}
+
+// append a number as two digits to a label
+constexpr void appendTwoDigits(labelStruct &label, int number)
+{
+  label.text[label.length++] = (char)('0' + number / 10);
+  label.text[label.length++] = (char)('0' + number % 10);
+}
+
+constexpr dateLabelTableStruct makeDateLabelTable()
+{
+  dateLabelTableStruct table = {};
+  for (int month = 1; month <= 12; ++month)
+  {
+    for (int day = 1; day <= LENGTH_OF_MONTH[month - 1]; ++day)
+    {
+      labelStruct &label = table.labels[START_OF_MONTH[month - 1] + day];
+      appendNumber(label, month);
+      label.text[label.length++] = '/';
+      appendNumber(label, day);
+    }
+  }
+  return table;
+}
+
+constexpr timeLabelTableStruct makeTimeLabelTable()
+{
+  timeLabelTableStruct table = {};
+  for (int minuteOfDay = 0; minuteOfDay <= MINUTES_PER_DAY; ++minuteOfDay)
+  {
+    labelStruct &label = table.labels[minuteOfDay];
+    appendTwoDigits(label, minuteOfDay / 60);
+    label.text[label.length++] = ':';
+    appendTwoDigits(label, minuteOfDay % 60);
+    label.text[label.length++] = ':';
+    appendTwoDigits(label, 0);
+  }
+  return table;
+}
+
+inline constexpr dateLabelTableStruct DATE_LABELS = makeDateLabelTable();
+inline constexpr timeLabelTableStruct TIME_LABELS = makeTimeLabelTable();
+
+static_assert(DATE_LABELS.labels[365].length == 5 && DATE_LABELS.labels[365].text[0] == '1' &&
+  DATE_LABELS.labels[365].text[4] == '1', "12/31 should be the last date label");
+static_assert(TIME_LABELS.labels[MINUTES_PER_DAY].length == 8 && TIME_LABELS.labels[MINUTES_PER_DAY].text[1] == '4',
+  "24:00:00 should be the last time label");
+
+// return the label of a day of the year (e.g. 1/1)
+// return an empty label if the date is out of range
+inline std::string_view dateLabel(int date)
+{
+  if (date < 1 || date > 365)
+  {
+    return std::string_view();
+  }
+  return std::string_view(DATE_LABELS.labels[date].text, DATE_LABELS.labels[date].length);
+}
+
+// return the label of a time in seconds of the day (e.g. 01:30:00)
+// return an empty label if the time is out of range or not a whole minute
+inline std::string_view timeLabel(int time)
+{
+  if (time < 0 || time > MINUTES_PER_DAY * 60 || time % 60 != 0)
+  {
+    return std::string_view();
+  }
+  const labelStruct &label = TIME_LABELS.labels[time / 60];
+  return std::string_view(label.text, label.length);
+}
@@ -0,0 +1,165 @@
+#include "dayCalendar.h"
+#include "config.h"
+#include "utils.h"
+#include "dateTables.h"
+
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// the names of the days of the week in the order of CONTAM (1 = Sunday)
+static const char *const WEEKDAY_NAMES[7] = { "sunday", "monday", "tuesday", "wednesday", "thursday",
+  "friday", "saturday" };
+
+static const char *const MONTH_NAMES[12] = { "january", "february", "march", "april", "may", "june",
+  "july", "august", "september", "october", "november", "december" };
+
+// the words for the week of the month in a rule (1-5)
+static const char *const ORDINAL_WORDS[5] = { "first", "second", "third", "fourth", "fifth" };
+static const char *const ORDINAL_NUMBERS[5] = { "1st", "2nd", "3rd", "4th", "5th" };
+
+// return the day of the week of a date in the weather file
+// the days of the week follow on from the start date, which is firstDOY, through the end of the year
+// and on into the start of the next one, the same as they are written in the head section
+// date - the date (1-365)
+// startDate - the first date of the weather file
+// firstDOY - the day of the week of the start date (1-7)
+// return the day of the week (1-7)
+int dayOfWeekOfDate(int date, int startDate, int firstDOY)
+{
+  int daysFromStart = (date - startDate + 365) % 365;
+  return (firstDOY - 1 + daysFromStart) % 7 + 1;
+}
+
+// return the index + 1 of a name in a list, the name can be the whole name or its first three letters
+// return 0 if the name is not in the list
+static int findName(const std::string &name, const char *const *names, int count)
+{
+  for (int index = 0; index < count; ++index)
+  {
+    if (name == names[index] || (name.length() == 3 && strncmp(name.c_str(), names[index], 3) == 0))
+    {
+      return index + 1;
+    }
+  }
+  return 0;
+}
+
+// read a rule for a special day such as "4th Thursday of November" or "last Monday of May"
+// the week is 1st-5th, first-fifth or last, the day and the month are names or their first three letters
+// and the month can also be a number (1-12), case does not matter
+// rule - the text of the rule
+// week - receives the week of the month (1-5, -1 = the last one)
+// weekday - receives the day of the week (1-7, 1 = Sunday)
+// month - receives the month (1-12)
+// return 0 if the rule was read and -1 if it is not a rule
+int readSpecialDayRule(const std::string &rule, int &week, int &weekday, int &month)
+{
+  std::string lowerRule = rule;
+  for (char &c : lowerRule)
+  {
+    c = (char)tolower((unsigned char)c);
+  }
+  std::vector<std::string> words;
+  std::vector<std::string> items;
+  split(lowerRule, ' ', items);
+  for (const std::string &item : items)
+  {
+    if (!item.empty())
+    {
+      words.push_back(item);
+    }
+  }
+  if (words.size() != 4 || words[2] != "of")
+  {
+    return -1;
+  }
+
+  if (words[0] == "last")
+  {
+    week = -1;
+  }
+  else
+  {
+    week = findName(words[0], ORDINAL_WORDS, 5);
+    if (week == 0)
+    {
+      week = findName(words[0], ORDINAL_NUMBERS, 5);
+    }
+    if (week == 0)
+    {
+      return -1;
+    }
+  }
+
+  weekday = findName(words[1], WEEKDAY_NAMES, 7);
+  if (weekday == 0)
+  {
+    return -1;
+  }
+
+  month = findName(words[3], MONTH_NAMES, 12);
+  if (month == 0)
+  {
+    size_t length = 0;
+    try
+    {
+      month = std::stoi(words[3], &length);
+    }
+    catch (...)
+    {
+      return -1;
+    }
+    if (length != words[3].length() || month < 1 || month > 12)
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// return the date that a rule for a special day falls on
+// week, weekday and month - the rule (see readSpecialDayRule)
+// startDate and firstDOY - give the days of the week of the dates (see dayOfWeekOfDate)
+// return the date (1-365) or -1 if the month doesn't have that week, e.g. a 5th Monday
+int specialDayRuleDate(int week, int weekday, int month, int startDate, int firstDOY)
+{
+  int firstDate = START_OF_MONTH[month - 1] + 1;
+  int lastDate = START_OF_MONTH[month - 1] + LENGTH_OF_MONTH[month - 1];
+  if (week < 0)
+  {
+    return lastDate - (dayOfWeekOfDate(lastDate, startDate, firstDOY) - weekday + 7) % 7;
+  }
+  int date = firstDate + (weekday - dayOfWeekOfDate(firstDate, startDate, firstDOY) + 7) % 7 + 7 * (week - 1);
+  if (date > lastDate)
+  {
+    return -1;
+  }
+  return date;
+}
+
+// compile the days of a config into a calendar
+// the special days are applied in order so a later one replaces an earlier one on the same date
+// config - a struct representation of the config file
+// startDate - the first date of the weather file
+// calendar - receives the tables of the days
+void compileDayCalendar(const configStruct &config, int startDate, dayCalendarStruct &calendar)
+{
+  calendar.startDate = startDate;
+  calendar.dayOfWeek[0] = 0;
+  calendar.dayType[0] = 0;
+  calendar.daylightSavings[0] = 0;
+  for (int date = 1; date <= 365; ++date)
+  {
+    int dayOfWeek = dayOfWeekOfDate(date, startDate, config.firstDOY);
+    calendar.dayOfWeek[date] = (unsigned char)dayOfWeek;
+    calendar.dayType[date] = (unsigned char)dayOfWeek;
+    calendar.daylightSavings[date] =
+      config.useDST && dateIsWithinRange(date, config.startDateDST, config.endDateDST) ? 1 : 0;
+  }
+  for (const specialDayStruct &specialDay : config.specialDays)
+  {
+    calendar.dayType[specialDay.date] = (unsigned char)specialDay.dtype;
+  }
+}
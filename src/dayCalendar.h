@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+
+struct configStruct;
+
+// the days of a config compiled into tables indexed by the date (1-365), index 0 is not used
+// the tables are built once for a config so writing the days of the weather file is a lookup
+struct dayCalendarStruct
+{
+  int startDate;                      // the date that has the day of the week config.firstDOY
+  unsigned char dayOfWeek[366];       // the day of the week (1-7)
+  unsigned char dayType[366];         // the day type (1-12), the day of the week unless it is a special day
+  unsigned char daylightSavings[366]; // 1 if DST is used on the date and 0 if not
+};
+
+int dayOfWeekOfDate(int date, int startDate, int firstDOY);
+int readSpecialDayRule(const std::string &rule, int &week, int &weekday, int &month);
+int specialDayRuleDate(int week, int weekday, int month, int startDate, int firstDOY);
+void compileDayCalendar(const configStruct &config, int startDate, dayCalendarStruct &calendar);
@@ -4,9 +4,119 @@
 #include "EPWConverter.h"
 #include "config.h"
 #include <emscripten.h>
-#include <sstream>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <streambuf>
+#include <string>
+
+// a stream buffer that appends to a string
+// the weather file is written straight into the string that JS reads it from
+class stringStreambuf : public std::streambuf
+{
+public:
+  explicit stringStreambuf(std::string &text) : text(text) {}
+
+protected:
+  std::streamsize xsputn(const char *data, std::streamsize count) override
+  {
+    text.append(data, (size_t)count);
+    return count;
+  }
+
+  int_type overflow(int_type ch) override
+  {
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      text.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+  }
+
+private:
+  std::string &text;
+};
+
+// the weather file of the last conversion, JS views it in the WASM memory with GetWTHData and GetWTHSize
+static std::string wthData;
+// the problem with the last conversion
+static std::string conversionErrMsg;
+
+// read the config of a conversion
+// configString - the contents of the config file (JSON), NULL or "" for the default config
+// config - receives the config
+// return 0 if the config was read and 1 if it is not valid, conversionErrMsg receives the problem
+static int readConfigString(const char *configString, configStruct &config)
+{
+  if (configString == NULL || configString[0] == '\0')
+  {
+    config.useDST = 0; // no DST
+    config.startDate = -1; // use EPW start date
+    config.endDate = -1; // use EPW end date
+    config.firstDOY = 1; // use Jan 01 = Sunday
+  }
+  else
+  {
+    cJSON *cnfJSON = cJSON_Parse(configString);
+    if (cnfJSON == NULL)
+    {
+      const char *error_ptr = cJSON_GetErrorPtr();
+      conversionErrMsg = std::string("Error before: ") + (error_ptr ? error_ptr : "");
+      return 1;
+    }
+    config = getConfigData(cnfJSON);
+    cJSON_Delete(cnfJSON);
+    if (!config.validConfig)
+    {
+      conversionErrMsg = config.errMsg;
+      return 1;
+    }
+  }
+#ifdef __EMSCRIPTEN_PTHREADS__
+  // the pthreads build converts the data in chunks on one thread per processor
+  // PTHREAD_POOL_SIZE starts that many workers so no thread has to wait for one to load
+  config.dataThreads = 0;
+#endif
+  return 0;
+}
+
+// convert an epw file in memory to a weather file in wthData
+// epwData - the contents of the epw file
+// epwSize - the number of bytes of epwData
+// configString - the contents of the config file (JSON), NULL or "" for the default config
+// return 0 if the conversion succeeded and 1 if it failed, conversionErrMsg receives the problem
+static int convertEPWToMemory(const char *epwData, size_t epwSize, const char *configString)
+{
+  // release the last weather file before making the next one
+  std::string().swap(wthData);
+  conversionErrMsg.clear();
+
+  configStruct config;
+  if (readConfigString(configString, config) != 0)
+  {
+    return 1;
+  }
+
+  // a weather file is usually about half the size of its epw file
+  wthData.reserve(epwSize / 2 + 4096);
+  stringStreambuf wthBuffer(wthData);
+  std::ostream wthStream(&wthBuffer);
+  conversionErrorStruct error;
+  if (convertEPW(config, epwData, epwData + epwSize, wthStream, error) != 0)
+  {
+    std::string().swap(wthData);
+    conversionErrMsg = error.errMsg;
+    return 1;
+  }
+  return 0;
+}
+
+// the conversion that JS runs a number of rows at a time with StartConversion and StepConversion
+// its weather file is written into wthData
+static epwConversionStruct steppedConversion;
+static stringStreambuf steppedBuffer(wthData);
+static std::ostream steppedStream(&steppedBuffer);
 
 extern "C" 
 {
@@ -26,62 +136,173 @@ extern "C"
   }
 
   //This function gets called to to an epw conversion
-  // epwString - is a string that holds the contents of the epw file
+  // epwPath - the path of the epw file in the virtual file system
   // configString - is a string that holds the contents of the config file (JSON)
+  // the weather file is passed to passWeatherFile() in the calling space
+  // ConvertEPWData below converts from the WASM memory without the file system
   int ConvertEPW(char *epwPath, char *configString)
   {
     std::cout << "ConvertEPW 1.0" << std::endl;
-    std::fstream epwStream;
-    std::ostringstream wthStream;
-    configStruct config;
+    std::ifstream epwStream;
 
     //open the epw stream
-    epwStream.open(epwPath);
+    epwStream.open(epwPath, std::ios::binary);
     //check that the file was opened
     if (epwStream.fail())
     {
       std::cerr << "Failed to open the epw file: " << epwPath << std::endl;
       return 1;
     }
+    std::string epwContents = std::string(std::istreambuf_iterator<char>(epwStream), {});
+    epwStream.close();
 
-    cJSON *cnfJSON;
-    cnfJSON = cJSON_Parse(configString);
-    if (cnfJSON == NULL)
+    if (convertEPWToMemory(epwContents.data(), epwContents.length(), configString) != 0)
     {
-      const char *error_ptr = cJSON_GetErrorPtr();
-      if (error_ptr != NULL)
-      {
-        std::cerr << "Error before: " << error_ptr << std::endl;
-        return 1;
-      }
+      std::cerr << conversionErrMsg << std::endl;
+      return 1;
     }
-    std::cout << "Config JSON Parsed" << std::endl;
+    std::string().swap(epwContents);
 
-    config = getConfigData(cnfJSON);
-    cJSON_Delete(cnfJSON);
-    if (!config.validConfig)
+    // pass the weather file to a function defined in the calling space
+    // it is decoded straight from the WASM memory so no script is built from it
+    EM_ASM({ passWeatherFile(UTF8ToString($0, $1)); }, wthData.data(), wthData.length());
+    std::string().swap(wthData);
+    return 0;
+  }
+
+  // allocate a block of the WASM memory for JS to copy an epw file into
+  // size - the number of bytes
+  // return the address of the block, it must be released with FreeEPW
+  EMSCRIPTEN_KEEPALIVE char *AllocateEPW(int size)
+  {
+    return (char *)malloc(size > 0 ? (size_t)size : 1);
+  }
+
+  // release a block from AllocateEPW
+  EMSCRIPTEN_KEEPALIVE void FreeEPW(char *epwData)
+  {
+    free(epwData);
+  }
+
+  // convert an epw file in the WASM memory to a weather file in the WASM memory
+  // JS views the weather file with HEAPU8.subarray(GetWTHData(), GetWTHData() + GetWTHSize())
+  // without copying it and calls FreeWTH when it is done with it
+  // epwData - the epw file, usually a block from AllocateEPW, it can be freed once this returns
+  // epwSize - the number of bytes of epwData
+  // configString - the contents of the config file (JSON), NULL or "" for the default config
+  // return 0 if the conversion succeeded and 1 if it failed, GetConversionError describes the problem
+  EMSCRIPTEN_KEEPALIVE int ConvertEPWData(const char *epwData, int epwSize, const char *configString)
+  {
+    if (epwData == NULL || epwSize < 0)
     {
-      std::cerr << config.errMsg << std::endl;
+      conversionErrMsg = "No epw data was given.";
       return 1;
     }
-    std::cout << "Config Struct completed" << std::endl;
+    return convertEPWToMemory(epwData, (size_t)epwSize, configString);
+  }
+
+  // return the address of the weather file of the last conversion
+  EMSCRIPTEN_KEEPALIVE const char *GetWTHData()
+  {
+    return wthData.data();
+  }
 
-    int retVal = convertEPW(config, epwStream, wthStream);
+  // return the number of bytes of the weather file of the last conversion
+  EMSCRIPTEN_KEEPALIVE int GetWTHSize()
+  {
+    return (int)wthData.length();
+  }
 
-    //create JS code snippet
-    std::string js_buffer;
+  // return the problem with the last conversion (null terminated)
+  EMSCRIPTEN_KEEPALIVE const char *GetConversionError()
+  {
+    return conversionErrMsg.c_str();
+  }
+
+  // release the weather file of the last conversion
+  EMSCRIPTEN_KEEPALIVE void FreeWTH()
+  {
+    std::string().swap(wthData);
+  }
 
-    //put the simdata into a js string
-    // and pass that string to a function defined in the calling space
-    js_buffer = " var wthdata = `";
-    js_buffer += wthStream.str();
-    js_buffer += "`;passWeatherFile(wthdata);";
+  // start a conversion that is done a number of rows at a time so it can run in a Web Worker
+  // that reports the progress and can be cancelled between the steps
+  // epwData - the epw file, usually a block from AllocateEPW, it must not be freed
+  //   until StepConversion has finished or CancelConversion has been called
+  // epwSize - the number of bytes of epwData
+  // configString - the contents of the config file (JSON), NULL or "" for the default config
+  // return 0 if the conversion was started and 1 if it failed, GetConversionError describes the problem
+  EMSCRIPTEN_KEEPALIVE int StartConversion(const char *epwData, int epwSize, const char *configString)
+  {
+    // release the last weather file before making the next one
+    steppedConversion.finished = true;
+    steppedConversion.writer.reset();
+    std::string().swap(steppedConversion.epwContents);
+    std::string().swap(wthData);
+    conversionErrMsg.clear();
+    if (epwData == NULL || epwSize < 0)
+    {
+      conversionErrMsg = "No epw data was given.";
+      return 1;
+    }
 
-    // run JS snippet
-    emscripten_run_script(js_buffer.c_str());
-    
+    configStruct config;
+    if (readConfigString(configString, config) != 0)
+    {
+      return 1;
+    }
+    // a weather file is usually about half the size of its epw file
+    wthData.reserve((size_t)epwSize / 2 + 4096);
+    conversionErrorStruct error;
+    if (startEPWConversion(config, epwData, epwData + epwSize, steppedStream, steppedConversion, error) != 0)
+    {
+      std::string().swap(wthData);
+      conversionErrMsg = error.errMsg;
+      return 1;
+    }
     return 0;
   }
+
+  // convert the next rows of the conversion from StartConversion
+  // Module.onConversionProgress(rowsDone, rowCount) is called after the step if it is defined
+  // once the conversion has finished the weather file is read with GetWTHData and GetWTHSize
+  // maxRows - the number of rows of data to convert in this step
+  // return 1 if there are more rows to convert, 0 if the conversion has finished
+  //   and -1 if it failed, GetConversionError describes the problem
+  EMSCRIPTEN_KEEPALIVE int StepConversion(int maxRows)
+  {
+    conversionErrorStruct error;
+    int retVal = stepEPWConversion(steppedConversion, maxRows, error);
+    if (retVal == -1)
+    {
+      std::string().swap(wthData);
+      conversionErrMsg = error.errMsg;
+    }
+    else
+    {
+      EM_ASM({
+        if (Module.onConversionProgress)
+        {
+          Module.onConversionProgress($0, $1);
+        }
+      }, steppedConversion.rowsDone, steppedConversion.rowCount);
+    }
+    if (steppedConversion.finished)
+    {
+      std::string().swap(steppedConversion.epwContents);
+    }
+    return retVal;
+  }
+
+  // stop the conversion from StartConversion and release what it has written
+  // the epw file can be freed once this returns
+  EMSCRIPTEN_KEEPALIVE void CancelConversion()
+  {
+    steppedConversion.finished = true;
+    steppedConversion.writer.reset();
+    std::string().swap(steppedConversion.epwContents);
+    std::string().swap(wthData);
+  }
 }
 
 #endif
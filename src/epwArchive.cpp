@@ -0,0 +1,702 @@
+#include "epwArchive.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/*
+  An epw file can be converted from a zip archive (the first *.epw member) or from a gzip file
+  without extracting it to disk. The member is inflated into memory and converted from there.
+  The deflate decoder below follows RFC 1951, the codes of up to FAST_BITS bits are decoded
+  with a lookup table and the longer ones one bit at a time.
+*/
+
+// the number of bits that are decoded with the lookup table of a huffman code
+const int FAST_BITS = 9;
+// the longest code of deflate
+const int MAX_CODE_BITS = 15;
+// the most that deflate can compress data, this limits the memory that is reserved for a corrupt size
+const size_t MAX_RATIO = 1032;
+
+// this holds a huffman code of deflate
+struct huffmanStruct
+{
+  short count[MAX_CODE_BITS + 1]; // the number of codes of each length
+  short symbol[288];              // the symbols ordered by their codes
+  // the symbol and the length of each code of up to FAST_BITS bits indexed by its reversed bits
+  // the length is 0 for the codes that are longer
+  unsigned short fast[1 << FAST_BITS];
+};
+
+// this holds the state of the deflate decoder
+struct inflateStateStruct
+{
+  const unsigned char *in; // the compressed data
+  size_t inLength;         // the number of bytes of compressed data
+  size_t inPosition;       // the next byte to read into the bit buffer
+  uint32_t bitBuffer;      // the bits that have been read and not used, the next bit is the lowest
+  int bitCount;            // the number of bits in the bit buffer
+  bool failed;             // true if the compressed data ended too soon
+  std::string *out;        // receives the inflated data
+};
+
+// read whole bytes into the bit buffer while there is room
+static inline void fillBits(inflateStateStruct &state)
+{
+  while (state.bitCount <= 24 && state.inPosition < state.inLength)
+  {
+    state.bitBuffer |= (uint32_t)state.in[state.inPosition++] << state.bitCount;
+    state.bitCount += 8;
+  }
+}
+
+// read some bits (up to 16), the first bit read is the lowest bit of the value
+static inline int readBits(inflateStateStruct &state, int count)
+{
+  if (state.bitCount < count)
+  {
+    fillBits(state);
+    if (state.bitCount < count)
+    {
+      state.failed = true;
+      return 0;
+    }
+  }
+  int value = (int)(state.bitBuffer & ((1u << count) - 1));
+  state.bitBuffer >>= count;
+  state.bitCount -= count;
+  return value;
+}
+
+// drop the bits of a partly used byte and give back the whole bytes of the bit buffer
+// so that the next byte can be read directly from the input
+static void alignToByte(inflateStateStruct &state)
+{
+  state.inPosition -= state.bitCount / 8;
+  state.bitBuffer = 0;
+  state.bitCount = 0;
+}
+
+// make a huffman code from the code length of each symbol
+// return 0 if the code is complete, more than 0 if it is incomplete and less than 0 if it is over subscribed
+static int buildHuffman(huffmanStruct &huffman, const short *lengths, int symbolCount)
+{
+  memset(huffman.count, 0, sizeof(huffman.count));
+  for (int symbol = 0; symbol < symbolCount; ++symbol)
+  {
+    ++huffman.count[lengths[symbol]];
+  }
+  memset(huffman.fast, 0, sizeof(huffman.fast));
+  if (huffman.count[0] == symbolCount)
+  {
+    // no codes, this is complete but any code that is read fails
+    return 0;
+  }
+
+  // check that the lengths make a valid code
+  int left = 1;
+  for (int length = 1; length <= MAX_CODE_BITS; ++length)
+  {
+    left <<= 1;
+    left -= huffman.count[length];
+    if (left < 0)
+    {
+      return left;
+    }
+  }
+
+  // order the symbols by their codes
+  short offsets[MAX_CODE_BITS + 1];
+  offsets[1] = 0;
+  for (int length = 1; length < MAX_CODE_BITS; ++length)
+  {
+    offsets[length + 1] = offsets[length] + huffman.count[length];
+  }
+  for (int symbol = 0; symbol < symbolCount; ++symbol)
+  {
+    if (lengths[symbol] != 0)
+    {
+      huffman.symbol[offsets[lengths[symbol]]++] = (short)symbol;
+    }
+  }
+
+  // fill the lookup table with the short codes
+  // the codes are assigned in the order of the symbols above, deflate sends them starting with the highest bit
+  int code = 0;
+  int index = 0;
+  for (int length = 1; length <= FAST_BITS; ++length)
+  {
+    for (int number = 0; number < huffman.count[length]; ++number, ++index, ++code)
+    {
+      int reversed = 0;
+      for (int bit = 0; bit < length; ++bit)
+      {
+        reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+      }
+      unsigned short entry = (unsigned short)((length << 9) | huffman.symbol[index]);
+      for (int fastIndex = reversed; fastIndex < (1 << FAST_BITS); fastIndex += 1 << length)
+      {
+        huffman.fast[fastIndex] = entry;
+      }
+    }
+    code <<= 1;
+  }
+  return left;
+}
+
+// decode a symbol with a huffman code
+// return the symbol or -1 if the bits are not a code
+static int decodeSymbol(inflateStateStruct &state, const huffmanStruct &huffman)
+{
+  fillBits(state);
+  unsigned short entry = huffman.fast[state.bitBuffer & ((1u << FAST_BITS) - 1)];
+  int length = entry >> 9;
+  if (length != 0 && length <= state.bitCount)
+  {
+    state.bitBuffer >>= length;
+    state.bitCount -= length;
+    return entry & 0x1ff;
+  }
+
+  // a longer code is decoded one bit at a time
+  int code = 0;
+  int first = 0;
+  int index = 0;
+  for (length = 1; length <= MAX_CODE_BITS; ++length)
+  {
+    code |= readBits(state, 1);
+    if (state.failed)
+    {
+      return -1;
+    }
+    int count = huffman.count[length];
+    if (code - count < first)
+    {
+      return huffman.symbol[index + (code - first)];
+    }
+    index += count;
+    first += count;
+    first <<= 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+// the base lengths and the extra bits of the length symbols 257 to 285
+static const short LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const short LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+// the base distances and the extra bits of the distance symbols 0 to 29
+static const unsigned short DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const short DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// inflate the symbols of a compressed block
+// return 0 at the end of the block and -1 if the data is not valid
+static int inflateCodes(inflateStateStruct &state, const huffmanStruct &lengthCode,
+  const huffmanStruct &distanceCode)
+{
+  std::string &out = *state.out;
+  for (;;)
+  {
+    int symbol = decodeSymbol(state, lengthCode);
+    if (symbol < 0)
+    {
+      return -1;
+    }
+    if (symbol < 256)
+    {
+      out.push_back((char)symbol);
+      continue;
+    }
+    if (symbol == 256)
+    {
+      return 0;
+    }
+
+    // copy a string that was already output
+    symbol -= 257;
+    if (symbol >= 29)
+    {
+      return -1;
+    }
+    size_t length = LENGTH_BASE[symbol] + readBits(state, LENGTH_EXTRA[symbol]);
+    symbol = decodeSymbol(state, distanceCode);
+    if (symbol < 0 || symbol >= 30)
+    {
+      return -1;
+    }
+    size_t distance = DISTANCE_BASE[symbol] + readBits(state, DISTANCE_EXTRA[symbol]);
+    if (state.failed || distance > out.size())
+    {
+      return -1;
+    }
+    size_t from = out.size() - distance;
+    size_t to = out.size();
+    out.resize(to + length);
+    char *data = &out[0];
+    // the string can overlap the bytes that it makes so it is copied one byte at a time
+    for (size_t index = 0; index < length; ++index)
+    {
+      data[to + index] = data[from + index];
+    }
+  }
+}
+
+// inflate a block that is not compressed
+// return 0 if the block was copied and -1 if the data is not valid
+static int inflateStored(inflateStateStruct &state)
+{
+  alignToByte(state);
+  if (state.inLength - state.inPosition < 4)
+  {
+    return -1;
+  }
+  const unsigned char *header = state.in + state.inPosition;
+  unsigned int length = header[0] | (header[1] << 8);
+  unsigned int complement = header[2] | (header[3] << 8);
+  state.inPosition += 4;
+  if (length != (~complement & 0xffff) || state.inLength - state.inPosition < length)
+  {
+    return -1;
+  }
+  state.out->append((const char *)state.in + state.inPosition, length);
+  state.inPosition += length;
+  return 0;
+}
+
+// inflate a block with the fixed huffman codes
+static int inflateFixed(inflateStateStruct &state)
+{
+  static huffmanStruct lengthCode;
+  static huffmanStruct distanceCode;
+  static bool built = []()
+  {
+    short lengths[288];
+    int symbol = 0;
+    for (; symbol < 144; ++symbol)
+    {
+      lengths[symbol] = 8;
+    }
+    for (; symbol < 256; ++symbol)
+    {
+      lengths[symbol] = 9;
+    }
+    for (; symbol < 280; ++symbol)
+    {
+      lengths[symbol] = 7;
+    }
+    for (; symbol < 288; ++symbol)
+    {
+      lengths[symbol] = 8;
+    }
+    buildHuffman(lengthCode, lengths, 288);
+    for (symbol = 0; symbol < 30; ++symbol)
+    {
+      lengths[symbol] = 5;
+    }
+    buildHuffman(distanceCode, lengths, 30);
+    return true;
+  }();
+  (void)built;
+  return inflateCodes(state, lengthCode, distanceCode);
+}
+
+// inflate a block with huffman codes that are given at the start of the block
+static int inflateDynamic(inflateStateStruct &state)
+{
+  // the order that the lengths of the code length code are sent in
+  static const short ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+  int lengthCount = readBits(state, 5) + 257;
+  int distanceCount = readBits(state, 5) + 1;
+  int codeCount = readBits(state, 4) + 4;
+  if (state.failed || lengthCount > 286 || distanceCount > 30)
+  {
+    return -1;
+  }
+
+  // read the code length code
+  short lengths[320];
+  int index = 0;
+  for (; index < codeCount; ++index)
+  {
+    lengths[ORDER[index]] = (short)readBits(state, 3);
+  }
+  for (; index < 19; ++index)
+  {
+    lengths[ORDER[index]] = 0;
+  }
+  huffmanStruct lengthCode;
+  if (state.failed || buildHuffman(lengthCode, lengths, 19) != 0)
+  {
+    return -1;
+  }
+
+  // read the lengths of the length and distance codes
+  for (index = 0; index < lengthCount + distanceCount;)
+  {
+    int symbol = decodeSymbol(state, lengthCode);
+    if (symbol < 0)
+    {
+      return -1;
+    }
+    if (symbol < 16)
+    {
+      lengths[index++] = (short)symbol;
+      continue;
+    }
+    short length = 0;
+    int repeat;
+    if (symbol == 16)
+    {
+      if (index == 0)
+      {
+        return -1;
+      }
+      length = lengths[index - 1];
+      repeat = 3 + readBits(state, 2);
+    }
+    else if (symbol == 17)
+    {
+      repeat = 3 + readBits(state, 3);
+    }
+    else
+    {
+      repeat = 11 + readBits(state, 7);
+    }
+    if (state.failed || index + repeat > lengthCount + distanceCount)
+    {
+      return -1;
+    }
+    while (repeat-- > 0)
+    {
+      lengths[index++] = length;
+    }
+  }
+  // the block must have an end of block code
+  if (lengths[256] == 0)
+  {
+    return -1;
+  }
+
+  // an incomplete code is only allowed when it has one symbol
+  huffmanStruct distanceCode;
+  int left = buildHuffman(lengthCode, lengths, lengthCount);
+  if (left < 0 || (left > 0 && lengthCount - lengthCode.count[0] != 1))
+  {
+    return -1;
+  }
+  left = buildHuffman(distanceCode, lengths + lengthCount, distanceCount);
+  if (left < 0 || (left > 0 && distanceCount - distanceCode.count[0] != 1))
+  {
+    return -1;
+  }
+  return inflateCodes(state, lengthCode, distanceCode);
+}
+
+// inflate deflate data
+// in - the compressed data
+// inLength - the number of bytes of compressed data
+// out - the inflated data is appended to this
+// used - receives the number of bytes of compressed data that were used
+// return 0 if the data was inflated and -1 if it is not valid
+static int inflateData(const unsigned char *in, size_t inLength, std::string &out, size_t &used)
+{
+  inflateStateStruct state;
+  state.in = in;
+  state.inLength = inLength;
+  state.inPosition = 0;
+  state.bitBuffer = 0;
+  state.bitCount = 0;
+  state.failed = false;
+  state.out = &out;
+
+  int last;
+  do
+  {
+    last = readBits(state, 1);
+    int type = readBits(state, 2);
+    int retVal;
+    if (state.failed)
+    {
+      return -1;
+    }
+    if (type == 0)
+    {
+      retVal = inflateStored(state);
+    }
+    else if (type == 1)
+    {
+      retVal = inflateFixed(state);
+    }
+    else if (type == 2)
+    {
+      retVal = inflateDynamic(state);
+    }
+    else
+    {
+      retVal = -1;
+    }
+    if (retVal != 0 || state.failed)
+    {
+      return -1;
+    }
+  } while (!last);
+
+  alignToByte(state);
+  used = state.inPosition;
+  return 0;
+}
+
+// compute the CRC-32 of some data, the same as zip and gzip
+static uint32_t crc32(const char *data, size_t length)
+{
+  static uint32_t table[256];
+  static bool built = []()
+  {
+    for (uint32_t index = 0; index < 256; ++index)
+    {
+      uint32_t value = index;
+      for (int bit = 0; bit < 8; ++bit)
+      {
+        value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+      }
+      table[index] = value;
+    }
+    return true;
+  }();
+  (void)built;
+
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t index = 0; index < length; ++index)
+  {
+    crc = table[(crc ^ (unsigned char)data[index]) & 0xff] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+static inline uint32_t read16(const unsigned char *data)
+{
+  return data[0] | (data[1] << 8);
+}
+
+static inline uint32_t read32(const unsigned char *data)
+{
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// check if some contents are a zip archive or a gzip file
+// begin - the first byte of the contents
+// end - one past the last byte of the contents
+// return true if the contents start like a zip archive or a gzip file
+bool isEPWArchive(const char *begin, const char *end)
+{
+  return (end - begin >= 4 && memcmp(begin, "PK\x03\x04", 4) == 0) ||
+    (end - begin >= 2 && memcmp(begin, "\x1f\x8b", 2) == 0);
+}
+
+// extract the first *.epw member of a zip archive
+static int extractZip(const unsigned char *begin, const unsigned char *end, std::string &epwContents,
+  std::string &errMsg)
+{
+  size_t length = end - begin;
+  // find the end of central directory record, it is followed by a comment of up to 65535 bytes
+  const size_t EOCD_SIZE = 22;
+  const unsigned char *eocd = NULL;
+  for (size_t back = EOCD_SIZE; back <= length && back <= EOCD_SIZE + 65535; ++back)
+  {
+    if (read32(end - back) == 0x06054b50)
+    {
+      eocd = end - back;
+      break;
+    }
+  }
+  if (eocd == NULL)
+  {
+    errMsg = "The zip archive does not have a central directory.";
+    return -1;
+  }
+  uint32_t entryCount = read16(eocd + 10);
+  uint32_t directoryOffset = read32(eocd + 16);
+  if (directoryOffset == 0xFFFFFFFF || directoryOffset > length)
+  {
+    errMsg = "The zip archive is not supported (zip64) or is not valid.";
+    return -1;
+  }
+
+  // find the first epw file in the central directory
+  const unsigned char *entry = begin + directoryOffset;
+  for (uint32_t index = 0; index < entryCount; ++index)
+  {
+    if (end - entry < 46 || read32(entry) != 0x02014b50)
+    {
+      break;
+    }
+    uint32_t flags = read16(entry + 8);
+    uint32_t method = read16(entry + 10);
+    uint32_t crc = read32(entry + 16);
+    uint32_t compressedSize = read32(entry + 20);
+    uint32_t uncompressedSize = read32(entry + 24);
+    uint32_t nameLength = read16(entry + 28);
+    uint32_t extraLength = read16(entry + 30);
+    uint32_t commentLength = read16(entry + 32);
+    uint32_t localOffset = read32(entry + 42);
+    if ((size_t)(end - entry) < 46 + nameLength)
+    {
+      break;
+    }
+    std::string name((const char *)entry + 46, nameLength);
+    entry += 46 + nameLength + extraLength + commentLength;
+
+    std::string ext = name.length() >= 4 ? name.substr(name.length() - 4) : "";
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext != ".epw")
+    {
+      continue;
+    }
+    if (flags & 1)
+    {
+      errMsg = "The epw file in the zip archive is encrypted: " + name;
+      return -1;
+    }
+    if (method != 0 && method != 8)
+    {
+      errMsg = "The epw file in the zip archive uses an unsupported compression method: " + name;
+      return -1;
+    }
+
+    // the data follows the local header, which has its own name and extra field
+    if (localOffset > length || length - localOffset < 30 || read32(begin + localOffset) != 0x04034b50)
+    {
+      errMsg = "The zip archive is not valid.";
+      return -1;
+    }
+    size_t dataOffset = (size_t)localOffset + 30 + read16(begin + localOffset + 26) +
+      read16(begin + localOffset + 28);
+    if (dataOffset > length || length - dataOffset < compressedSize)
+    {
+      errMsg = "The zip archive is truncated.";
+      return -1;
+    }
+    epwContents.clear();
+    if (method == 0)
+    {
+      epwContents.assign((const char *)begin + dataOffset, compressedSize);
+    }
+    else
+    {
+      epwContents.reserve(std::min((size_t)uncompressedSize, (size_t)compressedSize * MAX_RATIO));
+      size_t used;
+      if (inflateData(begin + dataOffset, compressedSize, epwContents, used) != 0)
+      {
+        errMsg = "The epw file in the zip archive could not be inflated: " + name;
+        return -1;
+      }
+    }
+    if (epwContents.length() != uncompressedSize ||
+      crc32(epwContents.data(), epwContents.length()) != crc)
+    {
+      errMsg = "The epw file in the zip archive is corrupt: " + name;
+      return -1;
+    }
+    return 0;
+  }
+  errMsg = "The zip archive does not contain an epw file.";
+  return -1;
+}
+
+// extract a gzip file, the members of a file with several are joined
+static int extractGzip(const unsigned char *begin, const unsigned char *end, std::string &epwContents,
+  std::string &errMsg)
+{
+  // the size of the last member is at the end of the file
+  if (end - begin >= 4)
+  {
+    epwContents.reserve(std::min((size_t)read32(end - 4), (size_t)(end - begin) * MAX_RATIO));
+  }
+  const unsigned char *cursor = begin;
+  while (end - cursor >= 10 && cursor[0] == 0x1f && cursor[1] == 0x8b)
+  {
+    if (cursor[2] != 8)
+    {
+      errMsg = "The gzip file uses an unsupported compression method.";
+      return -1;
+    }
+    // skip the optional fields of the header
+    int flags = cursor[3];
+    const unsigned char *data = cursor + 10;
+    if (flags & 4)
+    {
+      data = end - data >= 2 ? data + 2 + read16(data) : end;
+    }
+    for (int field = 8; field <= 16; field <<= 1)
+    {
+      if (flags & field)
+      {
+        data = std::find(std::min(data, end), end, 0);
+        data = data < end ? data + 1 : end;
+      }
+    }
+    if (flags & 2)
+    {
+      data += 2;
+    }
+    if (data >= end)
+    {
+      errMsg = "The gzip file is truncated.";
+      return -1;
+    }
+
+    size_t memberStart = epwContents.length();
+    size_t used;
+    if (inflateData(data, end - data, epwContents, used) != 0)
+    {
+      errMsg = "The gzip file could not be inflated.";
+      return -1;
+    }
+    const unsigned char *trailer = data + used;
+    if (end - trailer < 8)
+    {
+      errMsg = "The gzip file is truncated.";
+      return -1;
+    }
+    size_t memberLength = epwContents.length() - memberStart;
+    if (read32(trailer) != crc32(epwContents.data() + memberStart, memberLength) ||
+      read32(trailer + 4) != (uint32_t)memberLength)
+    {
+      errMsg = "The gzip file is corrupt.";
+      return -1;
+    }
+    cursor = trailer + 8;
+  }
+  return 0;
+}
+
+// extract the epw file of a zip archive or a gzip file into memory
+// the first member whose name ends with .epw is used from a zip archive
+// begin - the first byte of the archive
+// end - one past the last byte of the archive
+// epwContents - receives the epw file
+// errMsg - receives a description of the problem if the epw file can't be extracted
+// return 0 if the epw file was extracted and -1 if it could not be
+int extractEPWArchive(const char *begin, const char *end, std::string &epwContents, std::string &errMsg)
+{
+  epwContents.clear();
+  const unsigned char *first = (const unsigned char *)begin;
+  const unsigned char *last = (const unsigned char *)end;
+  if (end - begin >= 4 && memcmp(begin, "PK\x03\x04", 4) == 0)
+  {
+    return extractZip(first, last, epwContents, errMsg);
+  }
+  if (end - begin >= 2 && memcmp(begin, "\x1f\x8b", 2) == 0)
+  {
+    return extractGzip(first, last, epwContents, errMsg);
+  }
+  errMsg = "The file is not a zip archive or a gzip file.";
+  return -1;
+}
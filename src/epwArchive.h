@@ -0,0 +1,5 @@
+#pragma once
+#include <string>
+
+bool isEPWArchive(const char *begin, const char *end);
+int extractEPWArchive(const char *begin, const char *end, std::string &epwContents, std::string &errMsg);
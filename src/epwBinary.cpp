@@ -0,0 +1,191 @@
+#include "epwBinary.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// a binary epw file (*.epwb) holds the header and the columns of an epwStoreStruct
+// so that it can be converted again without parsing any text
+// all of the numbers are 4 or 8 bytes in the byte order of the computer that wrote the file
+// and every section starts on a multiple of 8 bytes so the columns can be used from a mapped file
+//
+//   offset  size  contents
+//   0       4     "EPWB"
+//   4       4     the version of the format (EPW_BINARY_VERSION)
+//   8       4     0x01020304 to check the byte order
+//   12      4     the length of the description in bytes
+//   16      4     the first day of the data period
+//   20      4     the last day of the data period
+//   24      8     the number of records
+//   32            the description (the location line) padded to 8 bytes
+//   then one column of 4 byte values for each field in the order of epwColumns below,
+//   each padded to 8 bytes
+
+// the size of the fixed part of the header
+const size_t EPW_BINARY_HEADER_SIZE = 32;
+const uint32_t EPW_BINARY_BYTE_ORDER = 0x01020304;
+
+// this is the fixed part of the header
+struct epwBinaryHeaderStruct
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t descriptionLength;
+  int32_t startDate;
+  int32_t endDate;
+  uint64_t recordCount;
+};
+
+// the number of padding bytes that make a size a multiple of 8
+static size_t paddingLength(size_t length)
+{
+  return (8 - length % 8) % 8;
+}
+
+// resize the columns of a store and return them in the order they are stored in the file
+// the int and float columns are all 4 bytes so they are handled as bytes
+static std::vector<void *> epwColumns(epwStoreStruct &store, size_t count)
+{
+  std::vector<int> *intColumns[] = { &store.date, &store.time, &store.Rn, &store.Sn };
+  std::vector<float> *floatColumns[] = { &store.Ta, &store.Td, &store.Pb, &store.Ws, &store.Wd,
+    &store.Ith, &store.Idn, &store.tenthsCloudCover, &store.Hr, &store.Ts };
+  std::vector<void *> columns;
+  for (std::vector<int> *column : intColumns)
+  {
+    column->resize(count);
+    columns.push_back(column->data());
+  }
+  for (std::vector<float> *column : floatColumns)
+  {
+    column->resize(count);
+    columns.push_back(column->data());
+  }
+  return columns;
+}
+
+// check if some contents are a binary epw file
+// begin - the first byte of the contents
+// end - one past the last byte of the contents
+// return true if the contents start like a binary epw file
+bool isEPWBinary(const char *begin, const char *end)
+{
+  return end - begin >= 4 && memcmp(begin, "EPWB", 4) == 0;
+}
+
+// write a store as a binary epw file
+// store - the parsed epw file
+// ostream - the stream where the binary epw file will be output
+// errMsg - receives a description of the problem if the file can't be written
+// return 0 if the file was written and -1 if it could not be
+int writeEPWBinary(const epwStoreStruct &store, std::ostream &ostream, std::string &errMsg)
+{
+  static_assert(sizeof(int) == 4 && sizeof(float) == 4, "the columns must be 4 bytes");
+  static_assert(sizeof(epwBinaryHeaderStruct) == EPW_BINARY_HEADER_SIZE, "unexpected header size");
+
+  size_t count = store.date.size();
+  epwBinaryHeaderStruct binaryHeader;
+  memcpy(binaryHeader.magic, "EPWB", 4);
+  binaryHeader.version = EPW_BINARY_VERSION;
+  binaryHeader.byteOrder = EPW_BINARY_BYTE_ORDER;
+  binaryHeader.descriptionLength = (uint32_t)store.header.description.length();
+  binaryHeader.startDate = store.header.startDate;
+  binaryHeader.endDate = store.header.endDate;
+  binaryHeader.recordCount = count;
+  const char padding[8] = { 0 };
+
+  ostream.write((const char *)&binaryHeader, sizeof(binaryHeader));
+  ostream.write(store.header.description.data(), store.header.description.length());
+  ostream.write(padding, paddingLength(store.header.description.length()));
+  // the columns are written in the same order as epwColumns
+  const std::vector<int> *intColumns[] = { &store.date, &store.time, &store.Rn, &store.Sn };
+  const std::vector<float> *floatColumns[] = { &store.Ta, &store.Td, &store.Pb, &store.Ws, &store.Wd,
+    &store.Ith, &store.Idn, &store.tenthsCloudCover, &store.Hr, &store.Ts };
+  for (const std::vector<int> *column : intColumns)
+  {
+    ostream.write((const char *)column->data(), count * 4);
+    ostream.write(padding, paddingLength(count * 4));
+  }
+  for (const std::vector<float> *column : floatColumns)
+  {
+    ostream.write((const char *)column->data(), count * 4);
+    ostream.write(padding, paddingLength(count * 4));
+  }
+  ostream.flush();
+  if (ostream.fail())
+  {
+    errMsg = "Failed to write the binary epw file.";
+    return -1;
+  }
+  return 0;
+}
+
+// read a binary epw file into a store
+// begin - the first byte of the binary epw file
+// end - one past the last byte of the binary epw file
+// store - receives the header and the data of the epw file
+// errMsg - receives a description of the problem if the file can't be read
+// return 0 if the file was read and -1 if it could not be
+int readEPWBinary(const char *begin, const char *end, epwStoreStruct &store, std::string &errMsg)
+{
+  size_t length = end - begin;
+  epwBinaryHeaderStruct binaryHeader;
+  if (!isEPWBinary(begin, end) || length < EPW_BINARY_HEADER_SIZE)
+  {
+    errMsg = "The binary epw file is not valid.";
+    return -1;
+  }
+  memcpy(&binaryHeader, begin, sizeof(binaryHeader));
+  if (binaryHeader.byteOrder != EPW_BINARY_BYTE_ORDER)
+  {
+    errMsg = "The binary epw file was written on a computer with a different byte order.";
+    return -1;
+  }
+  if (binaryHeader.version != EPW_BINARY_VERSION)
+  {
+    errMsg = "The binary epw file has an unsupported version: " + std::to_string(binaryHeader.version);
+    return -1;
+  }
+
+  // check that the file has all of the sections before reading them
+  size_t descriptionSize = binaryHeader.descriptionLength + paddingLength(binaryHeader.descriptionLength);
+  size_t columnCount = 14;
+  uint64_t count = binaryHeader.recordCount;
+  if (descriptionSize > length - EPW_BINARY_HEADER_SIZE ||
+    count > (length - EPW_BINARY_HEADER_SIZE - descriptionSize) / 4 / columnCount)
+  {
+    errMsg = "The binary epw file is truncated.";
+    return -1;
+  }
+  size_t columnSize = (size_t)count * 4 + paddingLength((size_t)count * 4);
+  if (EPW_BINARY_HEADER_SIZE + descriptionSize + columnCount * columnSize != length)
+  {
+    errMsg = "The binary epw file is truncated.";
+    return -1;
+  }
+
+  const char *cursor = begin + EPW_BINARY_HEADER_SIZE;
+  store.header.description.assign(cursor, binaryHeader.descriptionLength);
+  store.header.startDate = binaryHeader.startDate;
+  store.header.endDate = binaryHeader.endDate;
+  store.header.dataBegin = NULL;
+  cursor += descriptionSize;
+  std::vector<void *> columns = epwColumns(store, (size_t)count);
+  for (void *column : columns)
+  {
+    memcpy(column, cursor, (size_t)count * 4);
+    cursor += columnSize;
+  }
+
+  // the dates are used to look up labels so they must be in range
+  for (size_t index = 0; index < store.date.size(); ++index)
+  {
+    if (store.date[index] < 1 || store.date[index] > 365)
+    {
+      errMsg = "The binary epw file has an invalid date in record " + std::to_string(index + 1) + ".";
+      return -1;
+    }
+  }
+  return 0;
+}
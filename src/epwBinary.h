@@ -0,0 +1,11 @@
+#pragma once
+#include "epwStore.h"
+#include <ostream>
+#include <string>
+
+// the version of the binary epw format that writeEPWBinary writes
+const unsigned int EPW_BINARY_VERSION = 1;
+
+bool isEPWBinary(const char *begin, const char *end);
+int writeEPWBinary(const epwStoreStruct &store, std::ostream &ostream, std::string &errMsg);
+int readEPWBinary(const char *begin, const char *end, epwStoreStruct &store, std::string &errMsg);
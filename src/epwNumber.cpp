@@ -0,0 +1,78 @@
+#include "epwNumber.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// the length of the fields that are read from a copy on the stack, longer ones are copied to a string
+const size_t EPW_NUMBER_TEXT_SIZE = 64;
+
+// copy a field so that it ends with a null for strtol and strtof
+// text - the copy on the stack, it is used if the field fits
+// longText - the copy for a field that doesn't fit
+// return the copy
+static const char *terminateField(std::string_view field, char *text, std::string &longText)
+{
+  if (field.length() < EPW_NUMBER_TEXT_SIZE)
+  {
+    memcpy(text, field.data(), field.length());
+    text[field.length()] = '\0';
+    return text;
+  }
+  longText.assign(field);
+  return longText.c_str();
+}
+
+// read a field as an integer with strtol, the same as std::stoi
+// this is used for the fields that parseEPWInt doesn't read itself, e.g. a sign or space before the digits
+// the arguments are the same as parseEPWInt
+int parseEPWIntFallback(std::string_view field, int &value)
+{
+  char text[EPW_NUMBER_TEXT_SIZE];
+  std::string longText;
+  const char *start = terminateField(field, text, longText);
+  char *end;
+  // errno is kept the same as std::stoi keeps it
+  int savedErrno = errno;
+  errno = 0;
+  long result = strtol(start, &end, 10);
+  bool outOfRange = errno == ERANGE || result < INT_MIN || result > INT_MAX;
+  if (errno == 0)
+  {
+    errno = savedErrno;
+  }
+  if (end == start || outOfRange)
+  {
+    return -1;
+  }
+  value = (int)result;
+  return 0;
+}
+
+// read a field as a float with strtof, the same as std::stof
+// this is used for the fields that parseEPWFloat doesn't read itself, e.g. exponents or long decimals
+// the arguments are the same as parseEPWFloat
+int parseEPWFloatFallback(std::string_view field, float &value)
+{
+  char text[EPW_NUMBER_TEXT_SIZE];
+  std::string longText;
+  const char *start = terminateField(field, text, longText);
+  char *end;
+  // errno is kept the same as std::stof keeps it
+  int savedErrno = errno;
+  errno = 0;
+  float result = strtof(start, &end);
+  bool outOfRange = errno == ERANGE;
+  if (errno == 0)
+  {
+    errno = savedErrno;
+  }
+  if (end == start || outOfRange)
+  {
+    return -1;
+  }
+  value = result;
+  return 0;
+}
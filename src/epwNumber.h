@@ -0,0 +1,99 @@
+#pragma once
+#include <string_view>
+
+// reads the numbers of the fields of an epw file straight from the text of the field
+// the values are the same as std::stoi and std::stof give but nothing is copied or allocated
+// and a field that isn't a number is returned as -1 instead of an exception
+// the usual formats (-12.3, 101325) are read inline and anything else is read by strtol or strtof
+
+// the powers of ten that the decimals of the fast path are divided by, all of them are exact as floats
+inline constexpr double EPW_POWERS_OF_TEN[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+// the largest digits of the fast path, every integer up to it is exact as a float
+const unsigned int EPW_MAX_FAST_DIGITS = 1u << 24;
+
+// the most digits that the fast path reads
+const int EPW_FAST_DIGIT_COUNT = 9;
+
+int parseEPWIntFallback(std::string_view field, int &value);
+int parseEPWFloatFallback(std::string_view field, float &value);
+
+// read a field as an integer the same way std::stoi does
+// field - the text of the field
+// value - receives the integer
+// return 0 if the field was read and -1 if it doesn't start with an integer or the integer is too large
+inline int parseEPWInt(std::string_view field, int &value)
+{
+  const char *cursor = field.data();
+  const char *end = cursor + field.length();
+  bool negative = cursor < end && *cursor == '-';
+  cursor += negative;
+  const char *digits = cursor;
+  int result = 0;
+  while (cursor < end && (unsigned int)(*cursor - '0') <= 9 && cursor - digits < EPW_FAST_DIGIT_COUNT)
+  {
+    result = result * 10 + (*cursor - '0');
+    ++cursor;
+  }
+  // the fast path is only taken for a field that is all digits
+  if (cursor == end && cursor != digits)
+  {
+    value = negative ? -result : result;
+    return 0;
+  }
+  return parseEPWIntFallback(field, value);
+}
+
+// read a field in the usual format of the numbers of an epw file ([-]digits[.digits], at most 9 digits)
+// the digits are read as an integer and divided by a power of ten, both are exact floats so the quotient
+// computed as a double and rounded to a float is the correctly rounded value that strtof gives
+// field - the text of the field
+// value - receives the float
+// return true if the whole field was read and false if it isn't in the usual format
+inline bool parseEPWFloatFast(std::string_view field, float &value)
+{
+  const char *cursor = field.data();
+  const char *end = cursor + field.length();
+  bool negative = cursor < end && *cursor == '-';
+  cursor += negative;
+  unsigned int digits = 0;
+  int digitCount = 0;
+  while (cursor < end && (unsigned int)(*cursor - '0') <= 9 && digitCount < EPW_FAST_DIGIT_COUNT)
+  {
+    digits = digits * 10 + (*cursor - '0');
+    ++digitCount;
+    ++cursor;
+  }
+  int decimals = 0;
+  if (cursor < end && *cursor == '.')
+  {
+    ++cursor;
+    while (cursor < end && (unsigned int)(*cursor - '0') <= 9 && digitCount < EPW_FAST_DIGIT_COUNT)
+    {
+      digits = digits * 10 + (*cursor - '0');
+      ++digitCount;
+      ++decimals;
+      ++cursor;
+    }
+  }
+  if (cursor != end || digitCount == 0 || digits > EPW_MAX_FAST_DIGITS)
+  {
+    return false;
+  }
+  float result = (float)(digits / EPW_POWERS_OF_TEN[decimals]);
+  value = negative ? -result : result;
+  return true;
+}
+
+// read a field as a float the same way std::stof does
+// field - the text of the field
+// value - receives the float
+// return 0 if the field was read and -1 if it doesn't start with a number or the number is out of range
+inline int parseEPWFloat(std::string_view field, float &value)
+{
+  if (parseEPWFloatFast(field, value))
+  {
+    return 0;
+  }
+  return parseEPWFloatFallback(field, value);
+}
@@ -0,0 +1,168 @@
+#include "epwStore.h"
+#include "utils.h"
+#include "wthWriter.h"
+#include "psychrometrics.h"
+#include "epwArchive.h"
+
+#include <string>
+
+// parse the data section of an epw file into a store
+// every line with a valid date is kept so that any date range can be written from the store
+// epwBegin - the first byte of the epw file
+// epwEnd - one past the last byte of the epw file
+// store - receives the header and the data of the epw file
+// errMsg - receives a description of the problem if the epw file can't be parsed
+// return 0 if the epw file was parsed and -1 if it could not be
+int loadEPWStore(const char *epwBegin, const char *epwEnd, epwStoreStruct &store, std::string &errMsg)
+{
+  // the epw file of a zip archive or a gzip file is extracted into memory and parsed from there
+  if (isEPWArchive(epwBegin, epwEnd))
+  {
+    std::string epwContents;
+    if (extractEPWArchive(epwBegin, epwEnd, epwContents, errMsg) != 0)
+    {
+      return -1;
+    }
+    return loadEPWStore(epwContents.data(), epwContents.data() + epwContents.length(), store, errMsg);
+  }
+
+  int errField;
+  if (readEPWHeader(epwBegin, epwEnd, store.header, errField, errMsg) != 0)
+  {
+    return -1;
+  }
+  const char *cursor = store.header.dataBegin;
+  // the store does not keep the text of the epw file
+  store.header.dataBegin = NULL;
+
+  // most epw files have one line per hour of a year
+  std::vector<float> *floatColumns[] = { &store.Ta, &store.Td, &store.Pb, &store.Ws, &store.Wd,
+    &store.Ith, &store.Idn, &store.tenthsCloudCover };
+  std::vector<int> *intColumns[] = { &store.date, &store.time, &store.Rn, &store.Sn };
+  for (std::vector<float> *column : floatColumns)
+  {
+    column->clear();
+    column->reserve(8784);
+  }
+  for (std::vector<int> *column : intColumns)
+  {
+    column->clear();
+    column->reserve(8784);
+  }
+
+  epwRowStruct row;
+  wthRecordStruct record;
+  float dewPointTemperatureK;
+  float tenthsCloudCover;
+  // the data starts on line 9 of the epw file
+  int lineNumber = 9;
+  // process the lines of data until the end of the file or an empty line
+  for (; cursor < epwEnd && !lineIsEmpty(cursor, epwEnd); ++lineNumber)
+  {
+    cursor = tokenizeEPWRow(cursor, epwEnd, row);
+    int retVal = parseDataLine(row, 1, 365, record, dewPointTemperatureK, tenthsCloudCover, errField,
+      errMsg);
+    if (retVal == -1)
+    {
+      errMsg = "Line " + std::to_string(lineNumber) + ": " + errMsg;
+      return -1;
+    }
+    if (retVal == 1)
+    {
+      // the date is not in any range that can be written
+      continue;
+    }
+    store.date.push_back(record.date);
+    store.time.push_back(record.time);
+    store.Ta.push_back(record.Ta);
+    store.Td.push_back(dewPointTemperatureK);
+    store.Pb.push_back(record.Pb);
+    store.Ws.push_back(record.Ws);
+    store.Wd.push_back(record.Wd);
+    store.Ith.push_back(record.Ith);
+    store.Idn.push_back(record.Idn);
+    store.tenthsCloudCover.push_back(tenthsCloudCover);
+    store.Rn.push_back(record.Rn);
+    store.Sn.push_back(record.Sn);
+  }
+
+  // compute the derived columns for the whole file at once
+  size_t count = store.date.size();
+  store.Hr.resize(count);
+  store.Ts.resize(count);
+  psychrometricsBatch(store.Ta.data(), store.Td.data(), store.Pb.data(), store.tenthsCloudCover.data(),
+    store.Hr.data(), store.Ts.data(), count);
+
+  return 0;
+}
+
+// get one record of the weather file from a store
+// store - the parsed epw file
+// index - the index of the record in the columns of the store
+// record - receives the record
+void getStoreRecord(const epwStoreStruct &store, size_t index, wthRecordStruct &record)
+{
+  record.date = store.date[index];
+  record.time = store.time[index];
+  record.Ta = store.Ta[index];
+  record.Pb = store.Pb[index];
+  record.Ws = store.Ws[index];
+  record.Wd = store.Wd[index];
+  record.Hr = store.Hr[index];
+  record.Ith = store.Ith[index];
+  record.Idn = store.Idn[index];
+  record.Ts = store.Ts[index];
+  record.Rn = store.Rn[index];
+  record.Sn = store.Sn[index];
+}
+
+// write a CONTAM Weather file from a store
+// this gives the same weather file as convertEPW on the text of the epw file
+// except that a line that can't be parsed fails loadEPWStore even when it is outside the dates of the config
+// config - a struct representation of the config file
+// store - the parsed epw file
+// ostream - the stream where the CONTAM weather file will be output
+// errMsg - receives a description of the problem if the config does not fit the epw file
+// return 0 if the weather file was written and -1 if it could not be
+int convertEPWStore(const configStruct &config, const epwStoreStruct &store, std::ostream &ostream,
+  std::string &errMsg)
+{
+  wthWriter writer(&ostream, config.outputPrecision);
+  writer.compress(config.compressOutput ? config.compressTolerances : NULL);
+
+  int startDate;
+  int endDate;
+  if (writeWthHead(config, store.header, writer, startDate, endDate, errMsg) != 0)
+  {
+    return -1;
+  }
+  writeStoreRecords(store, startDate, endDate, writer);
+
+  return 0;
+}
+
+// write the records of a store whose dates are in a range
+// the records are written in the order of the epw file
+// store - the parsed epw file
+// startDate - the date to start outputing data
+// endDate - the date to end outputing data
+// writer - the writer of the weather file, the head section must already be written
+void writeStoreRecords(const epwStoreStruct &store, int startDate, int endDate, wthWriter &writer)
+{
+  bool firstRecord = true;
+  wthRecordStruct record;
+  for (size_t index = 0; index < store.date.size(); ++index)
+  {
+    if (!dateIsWithinRange(store.date[index], startDate, endDate))
+    {
+      continue;
+    }
+    getStoreRecord(store, index, record);
+    if (firstRecord)
+    {
+      writer.writeFirstRecord(record);
+    }
+    firstRecord = false;
+    writer.writeRecord(record, record.time);
+  }
+}
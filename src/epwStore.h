@@ -0,0 +1,34 @@
+#pragma once
+#include "EPWConverter.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// this holds the data section of an epw file with one array per field
+// the epw file is parsed once and any number of weather files can be written from the arrays
+struct epwStoreStruct
+{
+  epwHeaderStruct header; // the header of the epw file, the data section is not kept
+  // the columns below have one element for each line of data
+  std::vector<int> date;                // day of the year (1-365)
+  std::vector<int> time;                // seconds of the day (0-86400)
+  std::vector<float> Ta;                // dry bulb temperature [K]
+  std::vector<float> Td;                // dew point temperature [K]
+  std::vector<float> Pb;                // barometric pressure [Pa]
+  std::vector<float> Ws;                // wind speed [m/s]
+  std::vector<float> Wd;                // wind direction [deg]
+  std::vector<float> Ith;               // total horizontal solar radiation [kJ/m^2]
+  std::vector<float> Idn;               // direct normal solar radiation [kJ/m^2]
+  std::vector<float> tenthsCloudCover;  // total sky cover [tenths]
+  std::vector<int> Rn;                  // rain from the present weather codes (0 or 1)
+  std::vector<int> Sn;                  // snow from the snow depth (0 or 1)
+  // the columns below are derived from the ones above
+  std::vector<float> Hr;                // humidity ratio [g/kg]
+  std::vector<float> Ts;                // sky radiant temperature [K]
+};
+
+int loadEPWStore(const char *epwBegin, const char *epwEnd, epwStoreStruct &store, std::string &errMsg);
+void getStoreRecord(const epwStoreStruct &store, size_t index, wthRecordStruct &record);
+void writeStoreRecords(const epwStoreStruct &store, int startDate, int endDate, wthWriter &writer);
+int convertEPWStore(const configStruct &config, const epwStoreStruct &store, std::ostream &ostream,
+  std::string &errMsg);
@@ -0,0 +1,415 @@
+#include "epwValidator.h"
+#include "EPWConverter.h"
+#include "EPWTokenizer.h"
+#include "dateTables.h"
+#include "epwArchive.h"
+#include "epwBinary.h"
+#include "epwStore.h"
+#include "epwNumber.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the checks of validateEPW follow the ranges and missing values of the EnergyPlus weather file format
+
+// the upper limit of the fields that don't have one
+const double NO_LIMIT = std::numeric_limits<double>::max();
+
+// the range of a numeric field of an EPW data row
+struct epwFieldRangeStruct
+{
+  int field;        // the field (0 based, the same as epwRowStruct)
+  const char *name; // the name of the field for the messages
+  double minimum;   // the lowest valid value
+  double maximum;   // the highest valid value
+  double missing;   // the value that marks the field as missing
+  bool used;        // true if the converter uses the field, a missing value is a problem for those
+};
+
+// the numeric fields after the date and time
+// the total sky cover isn't marked as used since the converter treats a missing one as a clear sky
+static const epwFieldRangeStruct EPW_FIELD_RANGES[] =
+{
+  { 6, "dry bulb temperature", -70, 70, 99.9, true },
+  { 7, "dew point temperature", -70, 70, 99.9, true },
+  { 8, "relative humidity", 0, 110, 999, false },
+  { 9, "barometric pressure", 31000, 120000, 999999, true },
+  { 10, "extraterrestrial horizontal radiation", 0, NO_LIMIT, 9999, false },
+  { 11, "extraterrestrial direct normal radiation", 0, NO_LIMIT, 9999, false },
+  { 12, "horizontal infrared radiation", 0, NO_LIMIT, 9999, false },
+  { 13, "total horizontal solar radiation", 0, NO_LIMIT, 9999, true },
+  { 14, "direct normal solar radiation", 0, NO_LIMIT, 9999, true },
+  { 15, "diffuse horizontal solar radiation", 0, NO_LIMIT, 9999, false },
+  { 16, "global horizontal illuminance", 0, NO_LIMIT, 999999, false },
+  { 17, "direct normal illuminance", 0, NO_LIMIT, 999999, false },
+  { 18, "diffuse horizontal illuminance", 0, NO_LIMIT, 999999, false },
+  { 19, "zenith luminance", 0, NO_LIMIT, 9999, false },
+  { 20, "wind direction", 0, 360, 999, true },
+  { 21, "wind speed", 0, 40, 999, true },
+  { 22, "total sky cover", 0, 10, 99, false },
+  { 23, "opaque sky cover", 0, 10, 99, false },
+  { 24, "visibility", 0, NO_LIMIT, 9999, false },
+  { 25, "ceiling height", 0, NO_LIMIT, 99999, false },
+  { 26, "present weather observation", 0, 9, 9, false },
+  { 28, "precipitable water", 0, NO_LIMIT, 999, false },
+  { 29, "aerosol optical depth", 0, NO_LIMIT, 0.999, false },
+  { 30, "snow depth", 0, NO_LIMIT, 999, true }
+};
+
+// the start of each month - 1 in a leap year so that Feb 29 has a minute of the year of its own
+static const int LEAP_START_OF_MONTH[12] = { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335 };
+
+// the number of minutes in a leap year
+const int MINUTES_PER_LEAP_YEAR = 366 * MINUTES_PER_DAY;
+
+// the date and time of a row of data
+struct epwRowTimeStruct
+{
+  int month;
+  int day;
+  int hour;
+  int minute;
+};
+
+// read a field as a number, the whole field must be the number
+// the usual formats are read by parseEPWFloatFast and only other text is copied for strtod
+// field - the text of the field
+// value - receives the number
+// return true if the field is a finite number
+static bool readNumber(std::string_view field, double &value)
+{
+  float fastValue;
+  if (parseEPWFloatFast(field, fastValue))
+  {
+    value = fastValue;
+    return true;
+  }
+  // copy the field so it ends with a null, the fields are short so it is kept on the stack
+  char text[64];
+  if (field.empty() || field.length() >= sizeof(text))
+  {
+    return false;
+  }
+  memcpy(text, field.data(), field.length());
+  text[field.length()] = '\0';
+  char *end;
+  value = strtod(text, &end);
+  return end == text + field.length() && std::isfinite(value);
+}
+
+// add a problem to the list
+static void addProblem(std::vector<epwProblemStruct> &problems, int line, int field, const std::string &errMsg)
+{
+  epwProblemStruct problem;
+  problem.line = line;
+  problem.field = field;
+  problem.errMsg = errMsg;
+  problems.push_back(problem);
+}
+
+// format a number for a message without trailing zeros
+static std::string numberText(double value)
+{
+  char text[32];
+  snprintf(text, sizeof(text), "%g", value);
+  return text;
+}
+
+// format the date and time of a row for a message (M/D H:MM)
+static std::string rowTimeText(const epwRowTimeStruct &time)
+{
+  char text[32];
+  snprintf(text, sizeof(text), "%d/%d %d:%02d", time.month, time.day, time.hour, time.minute);
+  return text;
+}
+
+// read an integer field of the date and time and check its range
+// return true if the field is valid
+static bool checkIntField(const epwRowStruct &row, int field, const char *name, int minimum, int maximum,
+  int lineNumber, int &value, std::vector<epwProblemStruct> &problems)
+{
+  std::string_view text = row.fields[field];
+  double number;
+  if (!readNumber(text, number) || number != std::floor(number))
+  {
+    addProblem(problems, lineNumber, field + 1, "Failed to parse the " + std::string(name) + ". (" +
+      std::string(text) + ")");
+    return false;
+  }
+  if (number < minimum || number > maximum)
+  {
+    addProblem(problems, lineNumber, field + 1, "The " + std::string(name) + " is out of range (" +
+      std::to_string(minimum) + " to " + std::to_string(maximum) + "). (" + std::string(text) + ")");
+    return false;
+  }
+  value = (int)number;
+  return true;
+}
+
+// check the date and time of a row
+// time - receives the date and time
+// return true if they are valid
+static bool checkRowTime(const epwRowStruct &row, int lineNumber, epwRowTimeStruct &time,
+  std::vector<epwProblemStruct> &problems)
+{
+  int year;
+  bool valid = checkIntField(row, 0, "year", std::numeric_limits<int>::min(), std::numeric_limits<int>::max(),
+    lineNumber, year, problems);
+  bool validMonth = checkIntField(row, 1, "month", 1, 12, lineNumber, time.month, problems);
+  valid = validMonth && valid;
+  // Feb 29 is valid since a leap year has it
+  int monthLength = !validMonth ? 31 : time.month == 2 ? 29 : LENGTH_OF_MONTH[time.month - 1];
+  valid = checkIntField(row, 2, "day", 1, monthLength, lineNumber, time.day, problems) && valid;
+  valid = checkIntField(row, 3, "hour", 1, 24, lineNumber, time.hour, problems) && valid;
+  valid = checkIntField(row, 4, "minute", 0, 60, lineNumber, time.minute, problems) && valid;
+  return valid;
+}
+
+// check the numeric fields of a row after the date and time
+static void checkRowValues(const epwRowStruct &row, int lineNumber, std::vector<epwProblemStruct> &problems)
+{
+  for (const epwFieldRangeStruct &range : EPW_FIELD_RANGES)
+  {
+    if (range.field >= row.fieldCount)
+    {
+      return;
+    }
+    std::string_view text = row.fields[range.field];
+    double value;
+    if (!readNumber(text, value))
+    {
+      addProblem(problems, lineNumber, range.field + 1, "Failed to parse the " + std::string(range.name) +
+        ". (" + std::string(text) + ")");
+    }
+    // the fast path reads the fields as floats so the missing value is compared as a float
+    else if ((float)value == (float)range.missing)
+    {
+      if (range.used)
+      {
+        addProblem(problems, lineNumber, range.field + 1, "The " + std::string(range.name) + " is missing. (" +
+          std::string(text) + ")");
+      }
+    }
+    else if (value < range.minimum || value > range.maximum)
+    {
+      std::string limits = range.maximum == NO_LIMIT ? "at least " + numberText(range.minimum) :
+        numberText(range.minimum) + " to " + numberText(range.maximum);
+      addProblem(problems, lineNumber, range.field + 1, "The " + std::string(range.name) + " is out of range (" +
+        limits + "). (" + std::string(text) + ")");
+    }
+  }
+}
+
+// check the weather codes of a row, the converter reads the rain from the second of the 9 digits
+static void checkWeatherCodes(const epwRowStruct &row, int lineNumber, std::vector<epwProblemStruct> &problems)
+{
+  if (row.fieldCount <= 27)
+  {
+    return;
+  }
+  std::string_view codes = row.fields[27];
+  bool valid = codes.length() == 9;
+  for (size_t index = 0; valid && index < codes.length(); ++index)
+  {
+    valid = codes[index] >= '0' && codes[index] <= '9';
+  }
+  if (!valid)
+  {
+    addProblem(problems, lineNumber, 28, "Invalid weather codes, 9 digits are expected. (" +
+      std::string(codes) + ")");
+  }
+}
+
+// return the minute of a leap year that a row ends at
+static int minuteOfYear(const epwRowTimeStruct &time)
+{
+  return (LEAP_START_OF_MONTH[time.month - 1] + time.day - 1) * MINUTES_PER_DAY + (time.hour - 1) * 60 +
+    time.minute;
+}
+
+// return true if a row follows on from the previous one
+// step - the minutes between the rows
+static bool rowFollowsOn(const epwRowTimeStruct &previous, const epwRowTimeStruct &time, int step)
+{
+  int difference = minuteOfYear(time) - minuteOfYear(previous);
+  // the data can go on into the next year
+  if (difference < 0)
+  {
+    difference += MINUTES_PER_LEAP_YEAR;
+  }
+  if (difference == step)
+  {
+    return true;
+  }
+  // a year that isn't a leap year goes from Feb 28 to Mar 1
+  return difference == step + MINUTES_PER_DAY && previous.month == 2 && previous.day == 28 &&
+    time.month == 3 && time.day == 1;
+}
+
+// check the text of an epw file
+// the arguments are the same as validateEPW below
+static int validateEPWText(const char *epwBegin, const char *epwEnd, std::vector<epwProblemStruct> &problems,
+  size_t &rowCount)
+{
+  epwHeaderStruct header;
+  int errField = 0;
+  std::string errMsg;
+  if (readEPWHeader(epwBegin, epwEnd, header, errField, errMsg) != 0)
+  {
+    // the data periods are on line 8, the data can't be found without them
+    addProblem(problems, 8, errField, errMsg);
+    return -1;
+  }
+
+  // the rows should be this many minutes apart
+  int step = 0;
+  if (header.recordsPerHour >= 1 && header.recordsPerHour <= 60 && 60 % header.recordsPerHour == 0)
+  {
+    step = 60 / header.recordsPerHour;
+  }
+  else
+  {
+    addProblem(problems, 8, 3, "Invalid number of records per hour in the data periods. (" +
+      std::to_string(header.recordsPerHour) + ")");
+  }
+
+  epwRowStruct row;
+  epwRowTimeStruct time = {};
+  epwRowTimeStruct previous = {};
+  bool hasPrevious = false;
+  int emptyLine = 0;
+  bool reportedEmptyLine = false;
+  // the data starts on line 9 of the epw file
+  int lineNumber = 8;
+  const char *cursor = header.dataBegin;
+  while (cursor < epwEnd)
+  {
+    ++lineNumber;
+    std::string_view line;
+    cursor = getLine(cursor, epwEnd, line);
+    if (line.empty())
+    {
+      // the converter stops at the first empty line
+      if (emptyLine == 0)
+      {
+        emptyLine = lineNumber;
+      }
+      continue;
+    }
+    if (emptyLine != 0 && !reportedEmptyLine)
+    {
+      addProblem(problems, emptyLine, 0, "The data ends at an empty line, the lines after it are not converted.");
+      reportedEmptyLine = true;
+    }
+    ++rowCount;
+
+    const char *lineEnd = line.data() + line.length();
+    tokenizeEPWRow(line.data(), lineEnd, row);
+    // the tokenizer stops after the fields that are used, only the rest of the line is counted
+    int fieldCount = row.fieldCount;
+    if (fieldCount == EPW_USED_FIELDS)
+    {
+      const char *lastField = row.fields[EPW_USED_FIELDS - 1].data() + row.fields[EPW_USED_FIELDS - 1].length();
+      fieldCount += (int)std::count(lastField, lineEnd, ',');
+    }
+    if (fieldCount < EPW_USED_FIELDS)
+    {
+      addProblem(problems, lineNumber, fieldCount + 1, "Too few fields in a line of data. (" +
+        std::to_string(fieldCount) + ")");
+    }
+    else if (fieldCount != EPW_ROW_FIELDS)
+    {
+      addProblem(problems, lineNumber, 0, "The line of data has " + std::to_string(fieldCount) + " fields, " +
+        std::to_string(EPW_ROW_FIELDS) + " are expected.");
+    }
+
+    bool validTime = row.fieldCount > 4 && checkRowTime(row, lineNumber, time, problems);
+    checkRowValues(row, lineNumber, problems);
+    checkWeatherCodes(row, lineNumber, problems);
+
+    if (!validTime)
+    {
+      // the next row can't be checked against this one
+      hasPrevious = false;
+      continue;
+    }
+    if (rowCount == 1)
+    {
+      int date = START_OF_MONTH[time.month - 1] + std::min(time.day, LENGTH_OF_MONTH[time.month - 1]);
+      if (date != header.startDate)
+      {
+        addProblem(problems, lineNumber, 2, "The first row of data is not on the start date of the data period. (" +
+          rowTimeText(time) + ")");
+      }
+    }
+    if (hasPrevious && step != 0 && !rowFollowsOn(previous, time, step))
+    {
+      addProblem(problems, lineNumber, 2, "The date and time do not follow on from the row before. (" +
+        rowTimeText(time) + " after " + rowTimeText(previous) + ")");
+    }
+    previous = time;
+    hasPrevious = true;
+  }
+
+  if (rowCount == 0)
+  {
+    addProblem(problems, 9, 0, "There are no rows of data.");
+  }
+  return problems.empty() ? 0 : -1;
+}
+
+// check an epw file without converting it
+// every row of data is checked and all of the problems are reported, not just the first one:
+// the number of fields, that the fields are numbers within their ranges, the values that are missing
+// from the fields that the converter uses, the weather codes and that each row follows on from the one before
+// the epw file can also be a zip archive or a gzip file
+// only the format of a binary epw file is checked, its values were read by --compile but it stopped at the
+// first bad line and checked none of the rest, so the epw file that it was compiled from has to be validated
+// epwBegin - the first byte of the epw file
+// epwEnd - one past the last byte of the epw file
+// problems - receives the problems in the order of the lines
+// rowCount - receives the number of rows of data
+// dataChecked - receives false if only the format of a binary epw file was checked
+// return 0 if the epw file is valid and -1 if it has problems
+int validateEPW(const char *epwBegin, const char *epwEnd, std::vector<epwProblemStruct> &problems,
+  size_t &rowCount, bool &dataChecked)
+{
+  problems.clear();
+  rowCount = 0;
+  dataChecked = true;
+
+  std::string errMsg;
+  std::string epwContents;
+  if (isEPWArchive(epwBegin, epwEnd))
+  {
+    if (extractEPWArchive(epwBegin, epwEnd, epwContents, errMsg) != 0)
+    {
+      addProblem(problems, 0, 0, errMsg);
+      return -1;
+    }
+    epwBegin = epwContents.data();
+    epwEnd = epwContents.data() + epwContents.length();
+  }
+
+  // the values of a binary epw file are not checked, only its format
+  if (isEPWBinary(epwBegin, epwEnd))
+  {
+    dataChecked = false;
+    epwStoreStruct store;
+    if (readEPWBinary(epwBegin, epwEnd, store, errMsg) != 0)
+    {
+      addProblem(problems, 0, 0, errMsg);
+      return -1;
+    }
+    rowCount = store.date.size();
+    return 0;
+  }
+
+  return validateEPWText(epwBegin, epwEnd, problems, rowCount);
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// this holds one problem that validateEPW found in an epw file
+struct epwProblemStruct
+{
+  int line;           // the line of the epw file (1 based, 0 = the whole file)
+  int field;          // the field of the line (1 based, 0 = the whole line)
+  std::string errMsg; // a description of the problem
+};
+
+int validateEPW(const char *epwBegin, const char *epwEnd, std::vector<epwProblemStruct> &problems,
+  size_t &rowCount, bool &dataChecked);
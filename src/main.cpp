@@ -1,25 +1,172 @@
 #include "EPWConverter.h"
 #include "../lib/cJSON/cJSON.h"
 #include "config.h"
+#include "batchConverter.h"
+#include "conversionServer.h"
+#include "conversionStats.h"
+#include "utils.h"
 
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <iterator>
+#include <vector>
 
 #ifndef EMSCRIPTEN
 
+// read a config file
+// cnfPath - the path of the config file
+// config - receives the config
+// the problem is written to std::cerr if the config file can't be read
+// return 0 if the config was read and 1 if it could not be
+static int readConfigFile(const std::string &cnfPath, configStruct &config)
+{
+  std::string cnfFileContents;
+  cJSON *cnfJSON;
+  std::ifstream cnfStream;
+  cnfStream.open(cnfPath);
+  //check that the file was opened
+  if (cnfStream.fail())
+  {
+    std::cerr << "Failed to open the config file: " << cnfPath << std::endl;
+    return 1;
+  }
+  // read the whole file
+  cnfFileContents = std::string(std::istreambuf_iterator<char>(cnfStream), {});
+  cnfStream.close();
+  cnfJSON = cJSON_Parse(cnfFileContents.c_str());
+  if (cnfJSON == NULL)
+  {
+    const char *error_ptr = cJSON_GetErrorPtr();
+    if (error_ptr != NULL)
+    {
+      std::cerr << "Error before: " << error_ptr << std::endl;
+      return 1;
+    }
+  }
+
+  config = getConfigData(cnfJSON);
+  cJSON_Delete(cnfJSON);
+  if (!config.validConfig)
+  {
+    std::cerr << config.errMsg << std::endl;
+    return 1;
+  }
+
+  // check that the start date is after the end date
+  if (config.endDate < config.startDate)
+  {
+    std::cerr << "The start date cannot be after the end date." << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// get the path of an epw file without the extension of a gzip file
+// so that climate/station.epw.gz is named like climate/station.epw for the files made from it
+// epwPath - the epw file, a zip archive or a gzip file
+// return the path to replace the extension of
+static std::filesystem::path epwBasePath(const std::string &epwPath)
+{
+  std::filesystem::path p = epwPath;
+  std::string ext = p.extension().generic_string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  if (ext == ".gz")
+  {
+    p.replace_extension();
+  }
+  return p;
+}
+
+// write the counters and times of a conversion to std::cout
+// statsFormat - 0 to write nothing, 1 to write them as text and 2 to write them as JSON
+static void printStats(const conversionStatsStruct &stats, int statsFormat)
+{
+  if (statsFormat == 1)
+  {
+    std::cout << conversionStatsText(stats);
+  }
+  else if (statsFormat == 2)
+  {
+    std::cout << conversionStatsJSON(stats) << std::endl;
+  }
+}
+
+// read the tolerances of the --compress option
+// value - "default" or the 8 tolerances separated by commas (Ta,Pb,Ws,Wd,Hr,Ith,Idn,Ts)
+// tolerances - receives the tolerances
+// return 0 if the tolerances were read and 1 if they are not valid
+static int readTolerances(const std::string &value, float *tolerances)
+{
+  if (value == "default")
+  {
+    return 0;
+  }
+  std::vector<std::string> items;
+  split(value, ',', items);
+  if (items.size() != 8)
+  {
+    return 1;
+  }
+  for (size_t index = 0; index < items.size(); ++index)
+  {
+    try
+    {
+      tolerances[index] = std::stof(items[index]);
+    }
+    catch (...)
+    {
+      return 1;
+    }
+    if (!(tolerances[index] >= 0))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 // program to convert an epw file to a CONTAM weather file
 // the first argument is a path to a epw file to convert
 // second srgument is a path to a CONTAM weather file to create (*.wth)
 // the second argument is a path to a config file
 //the config file contains JSON with options for the conversion
+// several epw files, a directory or a wildcard pattern can be given instead of one epw file
+// to convert a batch of files with the same config
 int main(int argc, char *argv[])
 {
   std::string epwPath;
   std::string wthPath;
-  std::string cnfPath;
+  // the config files, a weather file is created for each one when there are several
+  std::vector<std::string> cnfPaths;
   configStruct config;
+  // the epw files, directories and patterns given for a batch conversion
+  std::vector<std::string> epwPaths;
+  std::vector<std::string> epwPatterns;
+  std::string outDir;
+  int threadCount = -1;
+  int precision = -1;
+  // the server reads jobs from stdin or from a socket instead of converting the files given
+  bool serverMode = false;
+  std::string socketPath;
+  // the conversion cache
+  std::string cacheDir;
+  unsigned long long cacheMaxBytes = 0;
+  bool seekDates = false;
+  // read, convert and write the blocks of a single epw file at the same time
+  bool pipeline = false;
+  // drop the records that are close to a line between the records that are kept
+  bool compressOutput = false;
+  float compressTolerances[8];
+  std::copy(std::begin(config.compressTolerances), std::end(config.compressTolerances), compressTolerances);
+  // compile the epw files to binary epw files instead of converting them
+  bool compileMode = false;
+  // check the epw files and report their problems without converting them
+  bool validateMode = false;
+  // write the counters and times of the conversion (0 = no, 1 = as text, 2 = as JSON)
+  int statsFormat = 0;
 
   // make sure that there is at least one param
   if (argc < 2)
@@ -39,24 +186,188 @@ int main(int argc, char *argv[])
     {
       printf("CONTAM_EPWtoWTH <EPW_File_Path> [WTH_File_Path] [CONFIG_File_Path]\n\
           \t<EPW_File_Path> is the path for the EPW file to convert.\n\
+          \t\tIt can also be a zip archive (the first EPW file in it is used) or a gzip file (*.epw.gz).\n\
           \t[WTH_File_Path] Optional path to CONTAM weather file.\n\
           \t\t If this option is not provided, then the output file will have the same name as the EPW_File_Path with the 'WTH' extension.\n\
           \t[CONFIG_File_Path] Optional path to configuration file.\n\
           \t\tIf provided, then the filename must include either the 'JSON' or 'CNF' extension to reflect the format of the configuration file provided.\n\
+          \t--precision <Digits> Optional number of decimals to write for the weather data (0-9).\n\
+          \t\tBy default 6 significant digits are written.\n\
+          \t--compress <Tolerances> Optional, leave out the records that are within the tolerances of a straight line\n\
+          \t\tbetween the records that are written, which makes sub-hourly weather files much smaller.\n\
+          \t\t<Tolerances> is \"default\" or 8 numbers separated by commas for Ta [K], Pb [Pa], Ws [m/s], Wd [deg],\n\
+          \t\tHr [g/kg], Ith [kJ/m^2], Idn [kJ/m^2] and Ts [K] (default 0.1,10,0.1,5,0.1,10,10,0.1).\n\
+          \t\tThe first and last records of each day are always written.\n\
+          \t--pipeline Optional, read the EPW file in blocks on one thread, convert the blocks on -j threads\n\
+          \t\tand write them on another so that reading, converting and writing overlap, the memory used stays the same for any size of file.\n\
+          \t\tIt cannot be used with several config files.\n\
+          \t--seek Optional, find the lines of the dates in the configuration with a binary search instead of reading every line.\n\
+          \t\tThis is faster for short date ranges, lines outside of the dates are not checked.\n\
+          \t--stats Optional, write the rows, the bytes and the time of each stage of the conversion.\n\
+          \t--stats-json Optional, the same as --stats written as a JSON object on one line.\n\
+          \t--cache <Directory> Optional directory of a cache of converted weather files.\n\
+          \t\tA weather file is copied from the cache when the same EPW file was converted with the same configuration before.\n\
+          \t--cache-size <Megabytes> Optional size limit of the cache, the least recently used files are removed (default 1024).\n\
+CONTAM_EPWtoWTH <EPW_File_Path> <CONFIG_File_Path>... [--outdir <Directory>]\n\
+          \tConverts one EPW file with several configurations in a single pass.\n\
+          \tThe weather file for each configuration is named <EPW name>_<CONFIG name>.wth.\n\
+CONTAM_EPWtoWTH <EPW_File_Path|EPW_Directory|EPW_Pattern>... [CONFIG_File_Path] [--outdir <Directory>] [-j <Threads>]\n\
+          \tConverts a batch of EPW files with the same configuration.\n\
+          \t<EPW_Directory> converts every EPW file in the directory.\n\
+          \t<EPW_Pattern> converts the files matching a pattern with the wildcards * and ? (e.g. climate/*.epw).\n\
+          \t--outdir <Directory> Optional directory for the weather files, by default each one is created next to its EPW file.\n\
+          \t-j <Threads> Optional number of files to convert at once, by default one per processor.\n\
+          \t\tWhen a single EPW file is given this is the number of threads that convert its data (0 = one per processor).\n\
+CONTAM_EPWtoWTH --compile <EPW_File_Path|EPW_Directory|EPW_Pattern>... [--outdir <Directory>]\n\
+          \tCompiles EPW files to binary EPW files (*.epwb) that are converted without parsing the text again.\n\
+          \tA binary EPW file can be given anywhere an EPW file can.\n\
+CONTAM_EPWtoWTH --validate <EPW_File_Path|EPW_Directory|EPW_Pattern>... [-j <Threads>]\n\
+          \tChecks EPW files without creating weather files and reports every problem as <EPW file>:<line>:<field>: <problem>.\n\
+          \tThe number of fields, the numbers and their ranges, missing values, the weather codes and that each row\n\
+          \tfollows on from the one before are checked. -j is the number of files to check at once, by default one per processor.\n\
+          \tOnly the format of a binary EPW file is checked, validate the EPW file that it was compiled from.\n\
+CONTAM_EPWtoWTH --server [-j <Threads>]\n\
+CONTAM_EPWtoWTH --socket <Socket_Path> [-j <Threads>]\n\
+          \tRuns conversion jobs given as JSON lines on stdin (--server) or on a Unix domain socket (--socket).\n\
+          \tEach job is an object with \"epw\" (path) or \"epwdata\" (contents), an optional \"config\" (object or path),\n\
+          \tan optional \"wth\" (path, without it the weather file is returned as \"wthdata\") and an optional \"id\".\n\
+          \tA JSON line with the status and the time is written for each job as it finishes.\n\
+          \t{\"shutdown\": true} stops the server after the jobs that were given.\n\
       ");
       return 0;
     }
+    if (argi == "--pipeline")
+    {
+      pipeline = true;
+      continue;
+    }
+    if (argi == "--seek")
+    {
+      seekDates = true;
+      continue;
+    }
+    if (argi == "--stats" || argi == "--stats-json")
+    {
+      statsFormat = argi == "--stats" ? 1 : 2;
+      continue;
+    }
+    if (argi == "--compile")
+    {
+      compileMode = true;
+      continue;
+    }
+    if (argi == "--validate")
+    {
+      validateMode = true;
+      continue;
+    }
+    if (argi == "--server")
+    {
+      serverMode = true;
+      continue;
+    }
+    if (argi == "--outdir" || argi == "-j" || argi == "--precision" || argi == "--socket" ||
+      argi == "--cache" || argi == "--cache-size" || argi == "--compress")
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << "The " << argi << " option requires a value." << std::endl;
+        return 1;
+      }
+      std::string value = argv[++i];
+      if (argi == "--outdir")
+      {
+        outDir = value;
+      }
+      else if (argi == "--cache")
+      {
+        cacheDir = value;
+      }
+      else if (argi == "--cache-size")
+      {
+        long long megabytes;
+        try
+        {
+          megabytes = std::stoll(value);
+        }
+        catch (...)
+        {
+          megabytes = -1;
+        }
+        if (megabytes <= 0)
+        {
+          std::cerr << "Invalid cache size: " << value << std::endl;
+          return 1;
+        }
+        cacheMaxBytes = (unsigned long long)megabytes * 1024 * 1024;
+      }
+      else if (argi == "--socket")
+      {
+        serverMode = true;
+        socketPath = value;
+      }
+      else if (argi == "--compress")
+      {
+        if (readTolerances(value, compressTolerances) != 0)
+        {
+          std::cerr << "Invalid compress tolerances: " << value << std::endl;
+          return 1;
+        }
+        compressOutput = true;
+      }
+      else if (argi == "--precision")
+      {
+        try
+        {
+          precision = std::stoi(value);
+        }
+        catch (...)
+        {
+          precision = -1;
+        }
+        if (precision < 0 || precision > 9)
+        {
+          std::cerr << "Invalid precision: " << value << std::endl;
+          return 1;
+        }
+      }
+      else
+      {
+        try
+        {
+          threadCount = std::stoi(value);
+        }
+        catch (...)
+        {
+          threadCount = -1;
+        }
+        if (threadCount < 0)
+        {
+          std::cerr << "Invalid number of threads: " << value << std::endl;
+          return 1;
+        }
+      }
+      continue;
+    }
+    std::error_code error;
+    if (argi.find_first_of("*?") != std::string::npos || std::filesystem::is_directory(argi, error))
+    {
+      epwPatterns.push_back(argi);
+      continue;
+    }
     std::filesystem::path path = argv[i];
     std::string ext = path.extension().generic_string();
     // change the extension to lowercase
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-    if (ext == ".epw")
+    // zip archives and gzip files are read without extracting them to disk
+    if (ext == ".epw" || ext == ".epwb" || ext == ".zip" || ext == ".gz")
     {
       epwPath = argv[i];
+      epwPaths.push_back(epwPath);
     }
     else if (ext == ".cnf" || ext == ".json")
     {
-      cnfPath = argv[i];
+      cnfPaths.push_back(argv[i]);
     }
     else if (ext == ".wth")
     {
@@ -70,69 +381,169 @@ int main(int argc, char *argv[])
     }
   }
 
+  if (serverMode)
+  {
+    unsigned int serverThreads = threadCount > 0 ? (unsigned int)threadCount : 0;
+    if (socketPath.empty())
+    {
+      return runJSONLinesServer(std::cin, std::cout, serverThreads);
+    }
+    std::string errMsg;
+    if (runSocketServer(socketPath, serverThreads, errMsg) != 0)
+    {
+      std::cerr << errMsg << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // more than one epw file, a directory or a pattern means a batch conversion
+  bool batchMode = epwPaths.size() > 1 || !epwPatterns.empty();
+  if (batchMode)
+  {
+    if (!wthPath.empty())
+    {
+      std::cerr << "A weather file path cannot be given when converting more than one epw file, use --outdir." << std::endl;
+      return 1;
+    }
+    for (size_t index = 0; index < epwPatterns.size(); ++index)
+    {
+      std::string errMsg;
+      if (findEPWFiles(epwPatterns[index], epwPaths, errMsg) != 0)
+      {
+        std::cerr << errMsg << std::endl;
+        return 1;
+      }
+    }
+    if (epwPaths.empty())
+    {
+      std::cerr << "No epw files were found to convert." << std::endl;
+      return 1;
+    }
+  }
+
   // check if an epw path was given
-  if (epwPath.empty())
+  if (epwPaths.empty())
   {
     // if not then can't proceed
     std::cerr << "No command-line parameter given for epw file." << std::endl;
     return 1;
   }
 
-  // if no wth path given then use epw path
-  if(wthPath.empty())
+  // check the epw files, several files are checked at once
+  if (validateMode)
   {
-    // convert the epw path to have a wth extension
-    std::filesystem::path p = epwPath;
-    std::filesystem::path temp = ".wth";
-    p.replace_extension(temp);
-    // use that path for the wth file
-    wthPath = p.generic_string();
+    int failures = validateEPWBatch(epwPaths, threadCount > 0 ? (unsigned int)threadCount : 0);
+    return failures == 0 ? 0 : 1;
   }
 
-  // bool to indicate if a config path was given
-  bool cnfFilePresent = !cnfPath.empty();
+  // the output directory is made once before any file is written into it
+  if (!outDir.empty())
+  {
+    std::error_code error;
+    std::filesystem::create_directories(outDir, error);
+    if (error)
+    {
+      std::cerr << "Failed to create the output directory " << outDir << ": " << error.message() << std::endl;
+      return 1;
+    }
+  }
 
-  //open streams
-  std::ifstream epwStream;
-  epwStream.open(epwPath);
-  //check that the file was opened
-  if (epwStream.fail())
+  // write a binary epw file next to each epw file or into the output directory
+  if (compileMode)
   {
-    std::cerr << "Failed to open the epw file: " << epwPath << std::endl;
-    return 1;
+    int failures = 0;
+    for (size_t index = 0; index < epwPaths.size(); ++index)
+    {
+      std::filesystem::path p = epwBasePath(epwPaths[index]);
+      p.replace_extension(".epwb");
+      if (!outDir.empty())
+      {
+        p = std::filesystem::path(outDir) / p.filename();
+      }
+      std::string errMsg;
+      if (compileEPWFile(epwPaths[index], p.generic_string(), errMsg) == 0)
+      {
+        std::cout << "Compiled: " << epwPaths[index] << " -> " << p.generic_string() << std::endl;
+      }
+      else
+      {
+        std::cout << "Failed: " << epwPaths[index] << ": " << errMsg << std::endl;
+        ++failures;
+      }
+    }
+    return failures == 0 ? 0 : 1;
   }
 
-  if (cnfFilePresent)
+  // several config files convert one epw file to a weather file for each config in one pass
+  if (cnfPaths.size() > 1)
   {
-    std::string cnfFileContents;
-    cJSON *cnfJSON;
-    std::ifstream cnfStream;
-    cnfStream.open(cnfPath);
-    //check that the file was opened
-    if (cnfStream.fail())
+    if (batchMode)
+    {
+      std::cerr << "Several config files can only be used with one epw file." << std::endl;
+      return 1;
+    }
+    if (!wthPath.empty())
+    {
+      std::cerr << "A weather file path cannot be given with several config files, use --outdir." << std::endl;
+      return 1;
+    }
+    if (statsFormat != 0)
+    {
+      std::cerr << "The --stats option cannot be used with several config files." << std::endl;
+      return 1;
+    }
+    if (pipeline)
     {
-      std::cerr << "Failed to open the config file: " << cnfPath << std::endl;
+      std::cerr << "The --pipeline option cannot be used with several config files." << std::endl;
       return 1;
     }
-    // read the whole file
-    cnfFileContents = std::string(std::istreambuf_iterator<char>(cnfStream), {});
-    cnfStream.close();
-    cnfJSON = cJSON_Parse(cnfFileContents.c_str());
-    if (cnfJSON == NULL)
+    std::vector<configStruct> configs(cnfPaths.size());
+    std::vector<std::string> wthPaths;
+    for (size_t index = 0; index < cnfPaths.size(); ++index)
     {
-      const char *error_ptr = cJSON_GetErrorPtr();
-      if (error_ptr != NULL)
+      if (readConfigFile(cnfPaths[index], configs[index]) != 0)
       {
-        std::cerr << "Error before: " << error_ptr << std::endl;
         return 1;
       }
+      configs[index].outputPrecision = precision;
+      configs[index].cacheDir = cacheDir;
+      configs[index].cacheMaxBytes = cacheMaxBytes;
+      configs[index].seekDates = seekDates;
+      configs[index].compressOutput = compressOutput;
+      std::copy(compressTolerances, compressTolerances + 8, configs[index].compressTolerances);
+      // each weather file is named after the epw file and its config file
+      std::filesystem::path p = epwBasePath(epwPath);
+      std::filesystem::path cnf = cnfPaths[index];
+      p.replace_filename(p.stem().generic_string() + "_" + cnf.stem().generic_string() + ".wth");
+      if (!outDir.empty())
+      {
+        p = std::filesystem::path(outDir) / p.filename();
+      }
+      wthPaths.push_back(p.generic_string());
     }
+    int failures = convertEPWFileConfigs(configs, epwPath, wthPaths);
+    return failures == 0 ? 0 : 1;
+  }
+
+  // if no wth path given then use epw path
+  if(wthPath.empty() && !batchMode)
+  {
+    // convert the epw path to have a wth extension
+    std::filesystem::path p = epwBasePath(epwPath);
+    std::filesystem::path temp = ".wth";
+    p.replace_extension(temp);
+    // use that path for the wth file
+    wthPath = p.generic_string();
+  }
+
+  // bool to indicate if a config path was given
+  bool cnfFilePresent = !cnfPaths.empty();
 
-    config = getConfigData(cnfJSON);
-    cJSON_Delete(cnfJSON);
-    if (!config.validConfig)
+  if (cnfFilePresent)
+  {
+    if (readConfigFile(cnfPaths[0], config) != 0)
     {
-      std::cerr << config.errMsg << std::endl;
       return 1;
     }
   }
@@ -145,29 +556,58 @@ int main(int argc, char *argv[])
     config.firstDOY = 1; // use Jan 01 = Sunday
   }
 
-  std::ofstream wthStream;
-  wthStream.open(wthPath);
-  //check that the file was opened
-  if (wthStream.fail())
+  config.outputPrecision = precision;
+  config.cacheDir = cacheDir;
+  config.cacheMaxBytes = cacheMaxBytes;
+  config.seekDates = seekDates;
+  config.pipeline = pipeline;
+  config.compressOutput = compressOutput;
+  std::copy(compressTolerances, compressTolerances + 8, config.compressTolerances);
+  conversionStatsStruct stats;
+  if (statsFormat != 0)
   {
-    std::cerr << "Failed to open the wth file: " << wthPath << std::endl;
-    return 1;
+    resetConversionStats(stats);
+    config.stats = &stats;
   }
 
-  // check that the start date is after the end date
-  if (config.endDate < config.startDate)
+  if (batchMode)
   {
-    std::cerr << "The start date cannot be after the end date." << std::endl;
-    return 1;
+    // the weather files go next to the epw files or into the output directory
+    std::vector<batchFileStruct> files;
+    for (size_t index = 0; index < epwPaths.size(); ++index)
+    {
+      batchFileStruct file;
+      file.epwPath = epwPaths[index];
+      std::filesystem::path p = epwBasePath(epwPaths[index]);
+      p.replace_extension(".wth");
+      if (!outDir.empty())
+      {
+        p = std::filesystem::path(outDir) / p.filename();
+      }
+      file.wthPath = p.generic_string();
+      files.push_back(file);
+    }
+    int failures = convertEPWBatch(config, files, threadCount > 0 ? (unsigned int)threadCount : 0);
+    printStats(stats, statsFormat);
+    return failures == 0 ? 0 : 1;
   }
 
-  int retVal = convertEPW(config, epwStream, wthStream);
-  epwStream.close();
-  wthStream.close();
+  // a single file is converted on several threads only when asked to
+  if (threadCount >= 0)
+  {
+    config.dataThreads = threadCount;
+  }
+
+  std::string errMsg;
+  int retVal = convertEPWFile(config, epwPath, wthPath, errMsg);
   if (retVal == 0)
     std::cout << "CONTAM Weather file created successfully." << std::endl;
   else
+  {
+    std::cerr << errMsg << std::endl;
     std::cout << "Weather file conversion failed." << std::endl;
+  }
+  printStats(stats, statsFormat);
   return retVal;
 }
 #endif
\ No newline at end of file
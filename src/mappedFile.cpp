@@ -0,0 +1,115 @@
+#include "mappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(EMSCRIPTEN)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// map a whole file into memory for reading
+// path - the path of the file to map
+// file - receives the mapping
+// return 0 if the file was mapped
+// return -1 if it could not be mapped (e.g. the path is a pipe)
+// in which case the caller should read it as a stream instead
+int mapFile(const std::string &path, mappedFileStruct &file)
+{
+  file.data = NULL;
+  file.size = 0;
+
+#if defined(_WIN32)
+  file.fileHandle = NULL;
+  file.mappingHandle = NULL;
+
+  HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    return -1;
+  }
+  LARGE_INTEGER fileSize;
+  if (GetFileType(fileHandle) != FILE_TYPE_DISK || !GetFileSizeEx(fileHandle, &fileSize) ||
+    fileSize.QuadPart == 0)
+  {
+    CloseHandle(fileHandle);
+    return -1;
+  }
+  HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mappingHandle == NULL)
+  {
+    CloseHandle(fileHandle);
+    return -1;
+  }
+  void *data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL)
+  {
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    return -1;
+  }
+  file.fileHandle = fileHandle;
+  file.mappingHandle = mappingHandle;
+  file.data = (const char *)data;
+  file.size = (size_t)fileSize.QuadPart;
+  return 0;
+#elif !defined(EMSCRIPTEN)
+  // only regular files can be mapped
+  // pipes and devices have to be read as streams
+  // this is checked before opening so that a pipe is left for the stream to read
+  struct stat fileStat;
+  if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0)
+  {
+    return -1;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    return -1;
+  }
+  if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0)
+  {
+    close(fd);
+    return -1;
+  }
+  void *data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    return -1;
+  }
+  // the file is read once from front to back
+  // so ask for aggressive read ahead and early release of the pages
+  madvise(data, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+  file.data = (const char *)data;
+  file.size = (size_t)fileStat.st_size;
+  return 0;
+#else
+  // the emscripten virtual file system is read through streams
+  return -1;
+#endif
+}
+
+// release a mapping created by mapFile
+void unmapFile(mappedFileStruct &file)
+{
+  if (file.data == NULL)
+  {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(file.data);
+  CloseHandle(file.mappingHandle);
+  CloseHandle(file.fileHandle);
+  file.fileHandle = NULL;
+  file.mappingHandle = NULL;
+#elif !defined(EMSCRIPTEN)
+  munmap((void *)file.data, file.size);
+#endif
+  file.data = NULL;
+  file.size = 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// this holds a read only memory mapping of a whole file
+struct mappedFileStruct
+{
+  const char *data; // the first byte of the file
+  size_t size;      // the number of bytes in the file
+#ifdef _WIN32
+  void *fileHandle;    // the handle of the open file
+  void *mappingHandle; // the handle of the file mapping
+#endif
+};
+
+int mapFile(const std::string &path, mappedFileStruct &file);
+void unmapFile(mappedFileStruct &file);
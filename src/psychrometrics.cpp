@@ -0,0 +1,372 @@
+#include "psychrometrics.h"
+#include "utils.h"
+
+// the batched versions of satpt, psywdp and skyTf from utils.cpp
+// the log and exp of the double precision parts are computed on SIMD registers
+// with the fdlibm algorithms (within 1 ulp) and the expressions are evaluated in the same
+// order as the scalar functions so the float results are the same as theirs
+
+// an Emscripten build with -msimd128 -msse2 compiles the SSE2 version to WASM SIMD
+// WASM has no AVX2 and no way to ask for it so that version is left out
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PSYCHROMETRICS_SSE2
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(_MSC_VER)) && !defined(__EMSCRIPTEN__)
+#define PSYCHROMETRICS_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#endif
+
+// water / air adjusted by 1.0044 (the same as psywdp)
+const float MASS_RATIO = 0.62472f;
+
+// fdlibm constants for log
+const double LN2_HI = 6.93147180369123816490e-01;
+const double LN2_LO = 1.90821492927058770002e-10;
+const double LG1 = 6.666666666666735130e-01;
+const double LG2 = 3.999999999940941908e-01;
+const double LG3 = 2.857142874366239149e-01;
+const double LG4 = 2.222219843214978396e-01;
+const double LG5 = 1.818357216161805012e-01;
+const double LG6 = 1.531383769920937332e-01;
+const double LG7 = 1.479819860511658591e-01;
+const double SQRT2 = 1.41421356237309514547;
+
+// fdlibm constants for exp
+const double INV_LN2 = 1.44269504088896338700e+00;
+const double EXP_P1 = 1.66666666666666019037e-01;
+const double EXP_P2 = -2.77777777770155933842e-03;
+const double EXP_P3 = 6.61375632143793436117e-05;
+const double EXP_P4 = -1.65339022054652515390e-06;
+const double EXP_P5 = 4.13813679705723846039e-08;
+
+// finish the float parts of psywdp and skyTf once the transcendental parts are known
+// saturationPressure - satpt of the dew point [Pa]
+// skyFactor - the fourth root of the effective sky emissivity
+static inline void finishRecord(float dryBulbK, float pressure, float saturationPressure, float skyFactor,
+  float &humidityRatio, float &skyTemperature)
+{
+  float w = saturationPressure * MASS_RATIO / (pressure - saturationPressure);
+  humidityRatio = 1000.0f * w;
+  skyTemperature = dryBulbK * skyFactor;
+}
+
+// compute the humidity ratio and sky temperature of a batch of records with the scalar functions
+// dryBulbK - dry bulb temperatures [K]
+// dewPointK - dew point temperatures [K]
+// pressure - barometric pressures [Pa]
+// tenthsCloudCover - tenths of cloud cover (0-10)
+// humidityRatio - receives the humidity ratios [g/kg]
+// skyTemperature - receives the sky radiant temperatures [K]
+// count - the number of records
+void psychrometricsBatchScalar(const float *dryBulbK, const float *dewPointK, const float *pressure,
+  const float *tenthsCloudCover, float *humidityRatio, float *skyTemperature, size_t count)
+{
+  for (size_t index = 0; index < count; ++index)
+  {
+    humidityRatio[index] = 1000.0f * psywdp(dewPointK[index], pressure[index]);
+    skyTemperature[index] = skyTf(dryBulbK[index], dewPointK[index], tenthsCloudCover[index]);
+  }
+}
+
+#ifdef PSYCHROMETRICS_SSE2
+
+// select a where the mask is set and b elsewhere
+static inline __m128d select2(__m128d mask, __m128d a, __m128d b)
+{
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+// natural log of two positive normal doubles
+static inline __m128d log2d(__m128d x)
+{
+  const __m128i bits = _mm_castpd_si128(x);
+  // split x into 2^k * m with m in [1, 2)
+  __m128i exponent = _mm_shuffle_epi32(_mm_srli_epi64(bits, 52), _MM_SHUFFLE(3, 1, 2, 0));
+  __m128d k = _mm_sub_pd(_mm_cvtepi32_pd(exponent), _mm_set1_pd(1023.0));
+  __m128d m = _mm_or_pd(_mm_and_pd(x, _mm_castsi128_pd(_mm_set1_epi64x(0x000fffffffffffffLL))),
+    _mm_set1_pd(1.0));
+  // move m into [sqrt(2)/2, sqrt(2))
+  __m128d large = _mm_cmpgt_pd(m, _mm_set1_pd(SQRT2));
+  m = select2(large, _mm_mul_pd(m, _mm_set1_pd(0.5)), m);
+  k = _mm_add_pd(k, _mm_and_pd(large, _mm_set1_pd(1.0)));
+
+  __m128d f = _mm_sub_pd(m, _mm_set1_pd(1.0));
+  __m128d hfsq = _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(0.5), f), f);
+  __m128d s = _mm_div_pd(f, _mm_add_pd(_mm_set1_pd(2.0), f));
+  __m128d z = _mm_mul_pd(s, s);
+  __m128d w = _mm_mul_pd(z, z);
+  __m128d t1 = _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LG2), _mm_mul_pd(w,
+    _mm_add_pd(_mm_set1_pd(LG4), _mm_mul_pd(w, _mm_set1_pd(LG6))))));
+  __m128d t2 = _mm_mul_pd(z, _mm_add_pd(_mm_set1_pd(LG1), _mm_mul_pd(w,
+    _mm_add_pd(_mm_set1_pd(LG3), _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LG5),
+    _mm_mul_pd(w, _mm_set1_pd(LG7))))))));
+  __m128d r = _mm_add_pd(t2, t1);
+  // k*ln2_hi - ((hfsq - (s*(hfsq+R) + k*ln2_lo)) - f)
+  __m128d inner = _mm_add_pd(_mm_mul_pd(s, _mm_add_pd(hfsq, r)), _mm_mul_pd(k, _mm_set1_pd(LN2_LO)));
+  return _mm_sub_pd(_mm_mul_pd(k, _mm_set1_pd(LN2_HI)), _mm_sub_pd(_mm_sub_pd(hfsq, inner), f));
+}
+
+// exp of two doubles in the range of the saturation pressure fit (well inside +-700)
+static inline __m128d exp2d(__m128d x)
+{
+  __m128i ki = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(INV_LN2)));
+  __m128d k = _mm_cvtepi32_pd(ki);
+  __m128d hi = _mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(LN2_HI)));
+  __m128d lo = _mm_mul_pd(k, _mm_set1_pd(LN2_LO));
+  __m128d r = _mm_sub_pd(hi, lo);
+  __m128d t = _mm_mul_pd(r, r);
+  __m128d c = _mm_sub_pd(r, _mm_mul_pd(t, _mm_add_pd(_mm_set1_pd(EXP_P1), _mm_mul_pd(t,
+    _mm_add_pd(_mm_set1_pd(EXP_P2), _mm_mul_pd(t, _mm_add_pd(_mm_set1_pd(EXP_P3), _mm_mul_pd(t,
+    _mm_add_pd(_mm_set1_pd(EXP_P4), _mm_mul_pd(t, _mm_set1_pd(EXP_P5)))))))))));
+  // 1 - ((lo - (r*c)/(2-c)) - hi)
+  __m128d y = _mm_sub_pd(_mm_set1_pd(1.0), _mm_sub_pd(_mm_sub_pd(lo,
+    _mm_div_pd(_mm_mul_pd(r, c), _mm_sub_pd(_mm_set1_pd(2.0), c))), hi));
+  // scale by 2^k
+  __m128i scale = _mm_slli_epi64(_mm_add_epi64(_mm_unpacklo_epi32(ki, _mm_setzero_si128()),
+    _mm_set1_epi64x(1023)), 52);
+  return _mm_mul_pd(y, _mm_castsi128_pd(scale));
+}
+
+// satpt of two dew points given as doubles
+static inline __m128d satpt2d(__m128d x)
+{
+  x = select2(_mm_cmplt_pd(x, _mm_set1_pd(203.0)), _mm_set1_pd(203.0), x);
+  x = select2(_mm_cmpgt_pd(x, _mm_set1_pd(373.0)), _mm_set1_pd(373.0), x);
+  __m128d logX = log2d(x);
+  // x < 273.16
+  __m128d cold = _mm_mul_pd(x, _mm_add_pd(_mm_set1_pd(-9.677843e-3), _mm_mul_pd(x,
+    _mm_add_pd(_mm_set1_pd(6.2215701e-7), _mm_mul_pd(x,
+    _mm_sub_pd(_mm_set1_pd(2.0747825e-9), _mm_mul_pd(x, _mm_set1_pd(9.484024e-13))))))));
+  cold = _mm_add_pd(_mm_sub_pd(_mm_add_pd(cold, _mm_mul_pd(_mm_set1_pd(4.1635019), logX)),
+    _mm_div_pd(_mm_set1_pd(5.6745359e3), x)), _mm_set1_pd(6.3925247));
+  // x >= 273.16
+  __m128d warm = _mm_mul_pd(x, _mm_add_pd(_mm_set1_pd(-4.8640239e-2), _mm_mul_pd(x,
+    _mm_sub_pd(_mm_set1_pd(4.1764768e-5), _mm_mul_pd(x, _mm_set1_pd(1.4452093e-8))))));
+  warm = _mm_add_pd(_mm_sub_pd(_mm_add_pd(warm, _mm_mul_pd(_mm_set1_pd(6.5459673), logX)),
+    _mm_div_pd(_mm_set1_pd(5.8002206e3), x)), _mm_set1_pd(1.3914993));
+  return exp2d(select2(_mm_cmplt_pd(x, _mm_set1_pd(273.16)), cold, warm));
+}
+
+// the fourth root of the effective sky emissivity for two records
+static inline __m128d skyFactor2d(__m128d dewPoint, __m128d cloudCover)
+{
+  __m128d es = _mm_add_pd(_mm_set1_pd(0.787), _mm_mul_pd(_mm_set1_pd(0.764),
+    log2d(_mm_div_pd(dewPoint, _mm_set1_pd(273.15)))));
+  __m128d cloud = _mm_add_pd(_mm_set1_pd(1.0), _mm_mul_pd(cloudCover, _mm_add_pd(_mm_set1_pd(0.0224),
+    _mm_mul_pd(cloudCover, _mm_add_pd(_mm_set1_pd(-0.0035), _mm_mul_pd(_mm_set1_pd(0.00028), cloudCover))))));
+  return _mm_sqrt_pd(_mm_sqrt_pd(_mm_mul_pd(es, cloud)));
+}
+
+// compute the humidity ratio and sky temperature of a batch of records two at a time
+static void psychrometricsBatchSSE2(const float *dryBulbK, const float *dewPointK, const float *pressure,
+  const float *tenthsCloudCover, float *humidityRatio, float *skyTemperature, size_t count)
+{
+  size_t index = 0;
+  for (; index + 2 <= count; index += 2)
+  {
+    __m128d dewPoint = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double *)(dewPointK + index))));
+    __m128d cloudCover = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double *)(tenthsCloudCover + index))));
+    alignas(16) float saturationPressure[4];
+    alignas(16) float skyFactor[4];
+    _mm_store_ps(saturationPressure, _mm_cvtpd_ps(satpt2d(dewPoint)));
+    _mm_store_ps(skyFactor, _mm_cvtpd_ps(skyFactor2d(dewPoint, cloudCover)));
+    for (size_t lane = 0; lane < 2; ++lane)
+    {
+      finishRecord(dryBulbK[index + lane], pressure[index + lane], saturationPressure[lane], skyFactor[lane],
+        humidityRatio[index + lane], skyTemperature[index + lane]);
+    }
+  }
+  psychrometricsBatchScalar(dryBulbK + index, dewPointK + index, pressure + index, tenthsCloudCover + index,
+    humidityRatio + index, skyTemperature + index, count - index);
+}
+
+#endif
+
+#ifdef PSYCHROMETRICS_AVX2
+
+#if defined(__GNUC__) && !defined(_MSC_VER)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+// natural log of four positive normal doubles
+AVX2_TARGET static inline __m256d log4d(__m256d x)
+{
+  const __m256i bits = _mm256_castpd_si256(x);
+  // split x into 2^k * m with m in [1, 2)
+  __m128i exponent = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_srli_epi64(bits, 52),
+    _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+  __m256d k = _mm256_sub_pd(_mm256_cvtepi32_pd(exponent), _mm256_set1_pd(1023.0));
+  __m256d m = _mm256_or_pd(_mm256_and_pd(x, _mm256_castsi256_pd(_mm256_set1_epi64x(0x000fffffffffffffLL))),
+    _mm256_set1_pd(1.0));
+  // move m into [sqrt(2)/2, sqrt(2))
+  __m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+  m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+  k = _mm256_add_pd(k, _mm256_and_pd(large, _mm256_set1_pd(1.0)));
+
+  __m256d f = _mm256_sub_pd(m, _mm256_set1_pd(1.0));
+  __m256d hfsq = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+  __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+  __m256d z = _mm256_mul_pd(s, s);
+  __m256d w = _mm256_mul_pd(z, z);
+  __m256d t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG2), _mm256_mul_pd(w,
+    _mm256_add_pd(_mm256_set1_pd(LG4), _mm256_mul_pd(w, _mm256_set1_pd(LG6))))));
+  __m256d t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LG1), _mm256_mul_pd(w,
+    _mm256_add_pd(_mm256_set1_pd(LG3), _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG5),
+    _mm256_mul_pd(w, _mm256_set1_pd(LG7))))))));
+  __m256d r = _mm256_add_pd(t2, t1);
+  __m256d inner = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)),
+    _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO)));
+  return _mm256_sub_pd(_mm256_mul_pd(k, _mm256_set1_pd(LN2_HI)), _mm256_sub_pd(_mm256_sub_pd(hfsq, inner), f));
+}
+
+// exp of four doubles in the range of the saturation pressure fit (well inside +-700)
+AVX2_TARGET static inline __m256d exp4d(__m256d x)
+{
+  __m128i ki = _mm256_cvtpd_epi32(_mm256_mul_pd(x, _mm256_set1_pd(INV_LN2)));
+  __m256d k = _mm256_cvtepi32_pd(ki);
+  __m256d hi = _mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(LN2_HI)));
+  __m256d lo = _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO));
+  __m256d r = _mm256_sub_pd(hi, lo);
+  __m256d t = _mm256_mul_pd(r, r);
+  __m256d c = _mm256_sub_pd(r, _mm256_mul_pd(t, _mm256_add_pd(_mm256_set1_pd(EXP_P1), _mm256_mul_pd(t,
+    _mm256_add_pd(_mm256_set1_pd(EXP_P2), _mm256_mul_pd(t, _mm256_add_pd(_mm256_set1_pd(EXP_P3),
+    _mm256_mul_pd(t, _mm256_add_pd(_mm256_set1_pd(EXP_P4), _mm256_mul_pd(t, _mm256_set1_pd(EXP_P5)))))))))));
+  __m256d y = _mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_sub_pd(_mm256_sub_pd(lo,
+    _mm256_div_pd(_mm256_mul_pd(r, c), _mm256_sub_pd(_mm256_set1_pd(2.0), c))), hi));
+  // scale by 2^k
+  __m256i scale = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(ki), _mm256_set1_epi64x(1023)), 52);
+  return _mm256_mul_pd(y, _mm256_castsi256_pd(scale));
+}
+
+// satpt of four dew points given as doubles
+AVX2_TARGET static inline __m256d satpt4d(__m256d x)
+{
+  x = _mm256_blendv_pd(x, _mm256_set1_pd(203.0), _mm256_cmp_pd(x, _mm256_set1_pd(203.0), _CMP_LT_OQ));
+  x = _mm256_blendv_pd(x, _mm256_set1_pd(373.0), _mm256_cmp_pd(x, _mm256_set1_pd(373.0), _CMP_GT_OQ));
+  __m256d logX = log4d(x);
+  // x < 273.16
+  __m256d cold = _mm256_mul_pd(x, _mm256_add_pd(_mm256_set1_pd(-9.677843e-3), _mm256_mul_pd(x,
+    _mm256_add_pd(_mm256_set1_pd(6.2215701e-7), _mm256_mul_pd(x,
+    _mm256_sub_pd(_mm256_set1_pd(2.0747825e-9), _mm256_mul_pd(x, _mm256_set1_pd(9.484024e-13))))))));
+  cold = _mm256_add_pd(_mm256_sub_pd(_mm256_add_pd(cold, _mm256_mul_pd(_mm256_set1_pd(4.1635019), logX)),
+    _mm256_div_pd(_mm256_set1_pd(5.6745359e3), x)), _mm256_set1_pd(6.3925247));
+  // x >= 273.16
+  __m256d warm = _mm256_mul_pd(x, _mm256_add_pd(_mm256_set1_pd(-4.8640239e-2), _mm256_mul_pd(x,
+    _mm256_sub_pd(_mm256_set1_pd(4.1764768e-5), _mm256_mul_pd(x, _mm256_set1_pd(1.4452093e-8))))));
+  warm = _mm256_add_pd(_mm256_sub_pd(_mm256_add_pd(warm, _mm256_mul_pd(_mm256_set1_pd(6.5459673), logX)),
+    _mm256_div_pd(_mm256_set1_pd(5.8002206e3), x)), _mm256_set1_pd(1.3914993));
+  return exp4d(_mm256_blendv_pd(warm, cold, _mm256_cmp_pd(x, _mm256_set1_pd(273.16), _CMP_LT_OQ)));
+}
+
+// the fourth root of the effective sky emissivity for four records
+AVX2_TARGET static inline __m256d skyFactor4d(__m256d dewPoint, __m256d cloudCover)
+{
+  __m256d es = _mm256_add_pd(_mm256_set1_pd(0.787), _mm256_mul_pd(_mm256_set1_pd(0.764),
+    log4d(_mm256_div_pd(dewPoint, _mm256_set1_pd(273.15)))));
+  __m256d cloud = _mm256_add_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(cloudCover,
+    _mm256_add_pd(_mm256_set1_pd(0.0224), _mm256_mul_pd(cloudCover, _mm256_add_pd(_mm256_set1_pd(-0.0035),
+    _mm256_mul_pd(_mm256_set1_pd(0.00028), cloudCover))))));
+  return _mm256_sqrt_pd(_mm256_sqrt_pd(_mm256_mul_pd(es, cloud)));
+}
+
+// compute the humidity ratio and sky temperature of a batch of records four at a time
+AVX2_TARGET static void psychrometricsBatchAVX2(const float *dryBulbK, const float *dewPointK,
+  const float *pressure, const float *tenthsCloudCover, float *humidityRatio, float *skyTemperature,
+  size_t count)
+{
+  size_t index = 0;
+  for (; index + 4 <= count; index += 4)
+  {
+    __m256d dewPoint = _mm256_cvtps_pd(_mm_loadu_ps(dewPointK + index));
+    __m256d cloudCover = _mm256_cvtps_pd(_mm_loadu_ps(tenthsCloudCover + index));
+    alignas(16) float saturationPressure[4];
+    alignas(16) float skyFactor[4];
+    _mm_store_ps(saturationPressure, _mm256_cvtpd_ps(satpt4d(dewPoint)));
+    _mm_store_ps(skyFactor, _mm256_cvtpd_ps(skyFactor4d(dewPoint, cloudCover)));
+    for (size_t lane = 0; lane < 4; ++lane)
+    {
+      finishRecord(dryBulbK[index + lane], pressure[index + lane], saturationPressure[lane], skyFactor[lane],
+        humidityRatio[index + lane], skyTemperature[index + lane]);
+    }
+  }
+  psychrometricsBatchSSE2(dryBulbK + index, dewPointK + index, pressure + index, tenthsCloudCover + index,
+    humidityRatio + index, skyTemperature + index, count - index);
+}
+
+// return true if the processor and operating system support AVX2
+static bool cpuHasAVX2()
+{
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  // OSXSAVE and AVX
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+    return false;
+  // the operating system saves the YMM registers
+  if ((_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+// pick the widest version that the processor supports
+static psychrometricsBatchFunction selectPsychrometricsBatch()
+{
+#ifdef PSYCHROMETRICS_AVX2
+  if (cpuHasAVX2())
+    return psychrometricsBatchAVX2;
+#endif
+#ifdef PSYCHROMETRICS_SSE2
+  return psychrometricsBatchSSE2;
+#else
+  return psychrometricsBatchScalar;
+#endif
+}
+
+// list the versions of the batch functions that the processor supports, widest first
+// this is for testing each of them against the scalar functions
+// versions - receives the versions, the scalar one is always last
+void psychrometricsBatchVersions(std::vector<psychrometricsBatchVersionStruct> &versions)
+{
+  versions.clear();
+#ifdef PSYCHROMETRICS_AVX2
+  if (cpuHasAVX2())
+    versions.push_back({ "AVX2", psychrometricsBatchAVX2 });
+#endif
+#ifdef PSYCHROMETRICS_SSE2
+  versions.push_back({ "SSE2", psychrometricsBatchSSE2 });
+#endif
+  versions.push_back({ "scalar", psychrometricsBatchScalar });
+}
+
+// compute the humidity ratio and sky temperature of a batch of records
+// this gives the same results as 1000 * psywdp(Td, Pb) and skyTf(Ta, Td, tcc)
+// but uses SSE2 or AVX2 when they are available
+// dryBulbK - dry bulb temperatures [K]
+// dewPointK - dew point temperatures [K]
+// pressure - barometric pressures [Pa]
+// tenthsCloudCover - tenths of cloud cover (0-10)
+// humidityRatio - receives the humidity ratios [g/kg]
+// skyTemperature - receives the sky radiant temperatures [K]
+// count - the number of records
+void psychrometricsBatch(const float *dryBulbK, const float *dewPointK, const float *pressure,
+  const float *tenthsCloudCover, float *humidityRatio, float *skyTemperature, size_t count)
+{
+  static const psychrometricsBatchFunction batchFunction = selectPsychrometricsBatch();
+  batchFunction(dryBulbK, dewPointK, pressure, tenthsCloudCover, humidityRatio, skyTemperature, count);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// the signature of the batch functions
+typedef void (*psychrometricsBatchFunction)(const float *, const float *, const float *, const float *,
+  float *, float *, size_t);
+
+// one version of psychrometricsBatch for an instruction set
+struct psychrometricsBatchVersionStruct
+{
+  const char *name;                     // the instruction set, e.g. "AVX2"
+  psychrometricsBatchFunction function; // the batch function that uses it
+};
+
+void psychrometricsBatch(const float *dryBulbK, const float *dewPointK, const float *pressure,
+  const float *tenthsCloudCover, float *humidityRatio, float *skyTemperature, size_t count);
+void psychrometricsBatchScalar(const float *dryBulbK, const float *dewPointK, const float *pressure,
+  const float *tenthsCloudCover, float *humidityRatio, float *skyTemperature, size_t count);
+void psychrometricsBatchVersions(std::vector<psychrometricsBatchVersionStruct> &versions);
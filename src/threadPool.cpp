@@ -0,0 +1,149 @@
+#include "threadPool.h"
+
+// the index of the pool worker running on this thread (-1 if it is not a worker)
+static thread_local int currentWorker = -1;
+// the pool that the worker running on this thread belongs to
+static thread_local const threadPool *currentPool = NULL;
+
+// start the worker threads
+// threadCount - the number of workers, 0 means one per hardware thread
+threadPool::threadPool(unsigned int threadCount)
+  : nextQueue(0), queuedTasks(0), unfinishedTasks(0), stopping(false)
+{
+  if (threadCount == 0)
+  {
+    threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+    {
+      threadCount = 1;
+    }
+  }
+  for (unsigned int index = 0; index < threadCount; ++index)
+  {
+    queues.push_back(std::make_unique<workerQueueStruct>());
+  }
+  for (unsigned int index = 0; index < threadCount; ++index)
+  {
+    workers.emplace_back(&threadPool::workerLoop, this, index);
+  }
+}
+
+// finish the queued tasks and stop the workers
+threadPool::~threadPool()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    stopping = true;
+  }
+  taskAvailable.notify_all();
+  for (size_t index = 0; index < workers.size(); ++index)
+  {
+    workers[index].join();
+  }
+}
+
+// queue a task to be run by one of the workers
+// a task submitted from a worker goes on that worker's own queue
+// otherwise the tasks are spread over the queues in turn
+void threadPool::submit(std::function<void()> task)
+{
+  unsigned int queueIndex;
+  if (currentPool == this)
+  {
+    queueIndex = (unsigned int)currentWorker;
+  }
+  else
+  {
+    queueIndex = nextQueue.fetch_add(1) % (unsigned int)queues.size();
+  }
+  // the task is counted before it is queued so a worker that takes it at once can't finish it
+  // before it is counted, otherwise the counts could wrap around and wait() could return early
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    ++queuedTasks;
+    ++unfinishedTasks;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+    queues[queueIndex]->tasks.push_back(std::move(task));
+  }
+  taskAvailable.notify_one();
+}
+
+// wait until every submitted task has finished
+// this must not be called from one of the pool's own tasks
+void threadPool::wait()
+{
+  std::unique_lock<std::mutex> lock(stateMutex);
+  tasksFinished.wait(lock, [this] { return unfinishedTasks == 0; });
+}
+
+// take a task for a worker
+// the newest task on the worker's own queue is taken first
+// then the oldest task from one of the other queues
+// return true if a task was taken
+bool threadPool::takeTask(unsigned int workerIndex, std::function<void()> &task)
+{
+  {
+    workerQueueStruct &own = *queues[workerIndex];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+    {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset < queues.size(); ++offset)
+  {
+    workerQueueStruct &victim = *queues[(workerIndex + offset) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty())
+    {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+// run tasks until the pool is stopped
+void threadPool::workerLoop(unsigned int workerIndex)
+{
+  currentWorker = (int)workerIndex;
+  currentPool = this;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(stateMutex);
+      taskAvailable.wait(lock, [this] { return stopping || queuedTasks > 0; });
+      if (queuedTasks == 0)
+      {
+        // stopping and there is nothing left to do
+        return;
+      }
+    }
+
+    std::function<void()> task;
+    if (!takeTask(workerIndex, task))
+    {
+      // another worker got to the task first
+      std::this_thread::yield();
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(stateMutex);
+      --queuedTasks;
+    }
+
+    task();
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (--unfinishedTasks == 0)
+    {
+      tasksFinished.notify_all();
+    }
+  }
+}
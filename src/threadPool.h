@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a pool of worker threads that run submitted tasks
+// each worker has its own queue of tasks, a worker takes the newest task from its own queue
+// and when that is empty it steals the oldest task from another worker's queue
+class threadPool
+{
+public:
+  explicit threadPool(unsigned int threadCount = 0);
+  ~threadPool();
+
+  threadPool(const threadPool &) = delete;
+  threadPool &operator=(const threadPool &) = delete;
+
+  void submit(std::function<void()> task);
+  void wait();
+  unsigned int threadCount() const { return (unsigned int)workers.size(); }
+
+private:
+  // the queue of tasks that belongs to one worker
+  struct workerQueueStruct
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void workerLoop(unsigned int workerIndex);
+  bool takeTask(unsigned int workerIndex, std::function<void()> &task);
+
+  std::vector<std::unique_ptr<workerQueueStruct>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<unsigned int> nextQueue;
+
+  std::mutex stateMutex;
+  std::condition_variable taskAvailable;  // signaled when a task is queued or the pool stops
+  std::condition_variable tasksFinished;  // signaled when the last unfinished task completes
+  size_t queuedTasks;     // tasks that are queued but not yet taken by a worker
+  size_t unfinishedTasks; // tasks that are queued or running
+  bool stopping;
+};
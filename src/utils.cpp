@@ -1,6 +1,10 @@
 #include "utils.h"
+#include "dateTables.h"
 #include <sstream>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
 
 // split a comma delimited string into a vector of strings
 std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems)
@@ -21,14 +25,12 @@ std::vector<std::string> &split(const std::string &s, char delim, std::vector<st
 // dom is not checked for each month so e.g. February 30th will return a value
 int doyFromMonthAndDay(int month, int dom)
 {
-  int som[12] =    /* start of month - 1 (day-of-year) */
-  { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
   if (month < 1 || month > 12)
     return -1;
   if (dom < 1 || dom > 31)
     return -1;
 
-  return (short)(som[month - 1] + dom);
+  return START_OF_MONTH[month - 1] + dom;
 }
 
 /***  satpt.c  ***************************************************************/
@@ -93,23 +95,7 @@ float skyTf(float Ta, float Td, float tcc)
 // return an empty string if the date given is out of range
 std::string IntDateXToStringDateX(int Date)
 {
-  std::string stringDate;
-  int month, day_of_month = 0;
-  int som[12] =    /* start of month - 1 (day-of-year) */
-  { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
-
-  if (Date < 1 || Date > 365)
-    return "";
-
-  for (month = 1; month < 12; month++)
-  {
-    if (som[month] >= Date) break;
-  }
-  day_of_month = Date - som[month - 1];
-
-  stringDate = std::to_string(month) + "/" + std::to_string(day_of_month);
-
-  return stringDate;
+  return std::string(dateLabel(Date));
 }
 
 // convert a seconds in the day time to a string time (HH:MM:SS)
@@ -122,6 +108,10 @@ std::string IntTimeToStringTime(int time)
   if (time < 0 || time > 86400)
     return"";
 
+  // whole minutes come from the table
+  if (time % 60 == 0)
+    return std::string(timeLabel(time));
+
   intMinutes = time / 60;
   intSeconds = time % 60;
   intHours = intMinutes / 60;
@@ -141,32 +131,70 @@ std::string IntTimeToStringTime(int time)
   return strHours + ":" + strMinutes + ":" + strSeconds;
 }
 
+// read the integer at the start of some text the same way std::stoi does
+// leading white space and a sign are allowed and anything after the digits is ignored
+// return the position after the digits or NULL if there are no digits
+static const char *readLeadingInt(const char *cursor, const char *end, int &value)
+{
+  while (cursor < end && (*cursor == ' ' || (*cursor >= '\t' && *cursor <= '\r')))
+    ++cursor;
+  bool negative = false;
+  if (cursor < end && (*cursor == '+' || *cursor == '-'))
+  {
+    negative = *cursor == '-';
+    ++cursor;
+  }
+  const char *digits = cursor;
+  value = 0;
+  // stop before the value could overflow, dates never get close to that
+  while (cursor < end && *cursor >= '0' && *cursor <= '9' && cursor - digits < 9)
+  {
+    value = value * 10 + (*cursor - '0');
+    ++cursor;
+  }
+  if (cursor == digits)
+    return NULL;
+  if (negative)
+    value = -value;
+  return cursor;
+}
+
 //convert a dateX string (1/1) to a day of the year
 // if a valid date cannot be determined then return -1
 int StringDateXToIntDateX(std::string Date)
 {
-  int c, day = 0, month = 0;
-  int lom[12] =    /* length of month - no leap year */
-  { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-  int som[12] =    /* start of month - 1 (day-of-year) */
-  { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+  int day = 0, month = 0;
+  const char *begin = Date.data();
+  const char *end = begin + Date.length();
 
-
-  c = Date.find("/", 0);
+  const char *slash = (const char *)memchr(begin, '/', Date.length());
   // if slash is not found
-  if (c == std::string::npos)
+  if (slash == NULL)
+  {
+    return -1;
+  }
+  if (readLeadingInt(begin, slash, month) == NULL || readLeadingInt(slash + 1, end, day) == NULL)
   {
     return -1;
   }
-  month = std::stoi(Date.substr(0, c));
-  day = std::stoi(Date.substr(c + 1, Date.length() - (c + 1)));
 
   // if date is out of range
-  if (month < 1 || month > 12 || day < 1 || day > lom[month - 1])
+  if (month < 1 || month > 12 || day < 1 || day > LENGTH_OF_MONTH[month - 1])
   {
     return -1;
   }
-  return (short)(som[month - 1] + day);
+  return START_OF_MONTH[month - 1] + day;
+}
+
+// parse a JSON text with cJSON_Parse one thread at a time
+// cJSON_Parse sets cJSON's global error pointer on every call so calls on several threads at once race on it
+// text - the JSON text
+// return the parsed JSON, which the caller deletes with cJSON_Delete, or NULL if it could not be parsed
+cJSON *parseJSON(const char *text)
+{
+  static std::mutex parseMutex;
+  std::lock_guard<std::mutex> lock(parseMutex);
+  return cJSON_Parse(text);
 }
 
 // get a double field from the JSON object given
@@ -11,6 +11,7 @@ float skyTf(float Ta, float Td, float tcc);
 std::string IntDateXToStringDateX(int Date);
 std::string IntTimeToStringTime(int time);
 int StringDateXToIntDateX(std::string Date);
+cJSON *parseJSON(const char *text);
 double getDoubleFromJSON(std::string fieldName, const cJSON *JSONObject);
 float getFloatFromJSON(std::string fieldName, const cJSON *JSONObject);
 int getIntFromJSON(std::string fieldName, const cJSON *JSONObject);
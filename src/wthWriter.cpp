@@ -0,0 +1,318 @@
+#include "wthWriter.h"
+#include "utils.h"
+#include "dateTables.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+// the longest text that a single number can be formatted to
+const size_t MAX_NUMBER_LENGTH = 64;
+
+// create a writer
+// ostream - the stream to write to, if this is NULL the output is kept in memory for takeOutput()
+// precision - the number of decimals to write for the floats
+//   -1 writes them the same way a default std::ostream does (6 significant digits)
+// blockSize - the number of bytes that are collected before they are written to the stream
+wthWriter::wthWriter(std::ostream *ostream, int precision, size_t blockSize)
+  : ostream(ostream), precision(precision), blockSize(blockSize), used(0), stats(NULL), compressing(false),
+  hasAnchor(false), hasEnd(false)
+{
+  buffer.resize(blockSize + 1024);
+}
+
+// write whatever is left in the buffer
+wthWriter::~wthWriter()
+{
+  flush();
+}
+
+// make room for the given number of bytes
+// the buffer is written to the stream first if it is full
+void wthWriter::reserve(size_t length)
+{
+  if (ostream && used > 0 && used + length > blockSize)
+  {
+    writeBlock();
+  }
+  if (used + length > buffer.length())
+  {
+    buffer.resize(std::max(buffer.length() * 2, used + length));
+  }
+}
+
+// write the buffer to the stream
+void wthWriter::writeBlock()
+{
+  if (stats)
+  {
+    double start = statsClock();
+    ostream->write(buffer.data(), used);
+    stats->stageSeconds[STAGE_WRITE] += statsClock() - start;
+    stats->bytesOut += used;
+  }
+  else
+  {
+    ostream->write(buffer.data(), used);
+  }
+  used = 0;
+}
+
+// write the buffer to the stream and flush the stream
+void wthWriter::flush()
+{
+  finishRecords();
+  if (ostream)
+  {
+    if (used > 0)
+    {
+      writeBlock();
+    }
+    ostream->flush();
+  }
+}
+
+// return the output that has been kept in memory and clear it
+std::string wthWriter::takeOutput()
+{
+  finishRecords();
+  buffer.resize(used);
+  std::string output;
+  output.swap(buffer);
+  used = 0;
+  buffer.resize(blockSize + 1024);
+  return output;
+}
+
+// return the output that has not been written to the stream or taken yet without clearing it
+std::string_view wthWriter::output() const
+{
+  return std::string_view(buffer.data(), used);
+}
+
+// measure the bytes that are written to the stream and the time that it takes
+// stats - receives the counters and times, NULL to stop measuring
+void wthWriter::measure(conversionStatsStruct *stats)
+{
+  this->stats = stats;
+}
+
+// drop the records that are close to a straight line between the records that are kept
+// a record is dropped when each of its values is within the tolerance of its column of the line
+// between the kept records before and after it, and its rain and snow are the same as theirs
+// this is done in one pass by keeping the range of slopes from the last kept record
+// that pass all the records dropped since it (the swinging door algorithm)
+// the first and last records of each day are always kept so a line never crosses a day boundary
+// tolerances - the tolerances of the WTH_FLOAT_COLUMNS columns, NULL to write every record
+void wthWriter::compress(const float *tolerances)
+{
+  finishRecords();
+  compressing = tolerances != NULL;
+  hasAnchor = false;
+  if (compressing)
+  {
+    std::copy(tolerances, tolerances + WTH_FLOAT_COLUMNS, this->tolerances);
+  }
+}
+
+// the float columns of a record in the order of the tolerances
+static inline void recordColumns(const wthRecordStruct &record, double *columns)
+{
+  columns[0] = record.Ta;
+  columns[1] = record.Pb;
+  columns[2] = record.Ws;
+  columns[3] = record.Wd;
+  columns[4] = record.Hr;
+  columns[5] = record.Ith;
+  columns[6] = record.Idn;
+  columns[7] = record.Ts;
+}
+
+// start a new line from the anchor with every slope allowed
+void wthWriter::resetSlopes()
+{
+  for (int column = 0; column < WTH_FLOAT_COLUMNS; ++column)
+  {
+    slopeLow[column] = -std::numeric_limits<double>::infinity();
+    slopeHigh[column] = std::numeric_limits<double>::infinity();
+  }
+}
+
+// write the record that is waiting after the anchor
+void wthWriter::finishRecords()
+{
+  if (hasEnd)
+  {
+    writeLine(end, endTime);
+    hasEnd = false;
+  }
+  hasAnchor = false;
+}
+
+// write some text as is
+void wthWriter::writeText(std::string_view text)
+{
+  finishRecords();
+  appendText(text);
+}
+
+// add some text to the buffer
+void wthWriter::appendText(std::string_view text)
+{
+  reserve(text.length());
+  memcpy(&buffer[used], text.data(), text.length());
+  used += text.length();
+}
+
+// write a float using the writer's precision
+// there must be room in the buffer for MAX_NUMBER_LENGTH bytes
+void wthWriter::writeFloat(float value)
+{
+  char *first = &buffer[used];
+  std::to_chars_result result;
+  if (precision < 0)
+  {
+    // the same as the %g format that a default stream uses
+    result = std::to_chars(first, first + MAX_NUMBER_LENGTH, value, std::chars_format::general, 6);
+  }
+  else
+  {
+    result = std::to_chars(first, first + MAX_NUMBER_LENGTH, value, std::chars_format::fixed, precision);
+  }
+  used += result.ptr - first;
+}
+
+// write an integer
+// there must be room in the buffer for MAX_NUMBER_LENGTH bytes
+void wthWriter::writeInt(int value)
+{
+  char *first = &buffer[used];
+  std::to_chars_result result = std::to_chars(first, first + MAX_NUMBER_LENGTH, value);
+  used += result.ptr - first;
+}
+
+// write a line of the day type definitions in the header section
+void wthWriter::writeDay(int date, int dayOfWeek, int dayType, int daylightSavings)
+{
+  writeText(dateLabel(date));
+  reserve(3 * (MAX_NUMBER_LENGTH + 1) + 8);
+  buffer[used++] = '\t';
+  writeInt(dayOfWeek);
+  buffer[used++] = '\t';
+  writeInt(dayType);
+  buffer[used++] = '\t';
+  writeInt(daylightSavings);
+  memcpy(&buffer[used], "\t283.15\n", 8);
+  used += 8;
+}
+
+// write the start of the data for the first record of the weather file
+// CONTAM requires the first line of data to be at time 0 so a record at a later time
+// is written a second time with time 0 before it is written itself
+// record - the first record of the weather file, the caller writes it with writeRecord after this
+void wthWriter::writeFirstRecord(const wthRecordStruct &record)
+{
+  if (record.time != 0)
+  {
+    writeRecord(record, 0);
+  }
+}
+
+// write a record of data
+// when compress() was called the record may be dropped or held until the next record shows whether it is needed
+// record - the record to write
+// time - the time to write for the record in seconds of the day
+void wthWriter::writeRecord(const wthRecordStruct &record, int time)
+{
+  if (!compressing)
+  {
+    writeLine(record, time);
+    return;
+  }
+
+  // keep the first record of each day
+  if (!hasAnchor || record.date != anchor.date || time <= anchorTime)
+  {
+    finishRecords();
+    writeLine(record, time);
+    anchor = record;
+    anchorTime = time;
+    hasAnchor = true;
+    resetSlopes();
+    return;
+  }
+  if (!hasEnd)
+  {
+    end = record;
+    endTime = time;
+    hasEnd = true;
+    return;
+  }
+
+  // the end record can be dropped if the line from the anchor to this record passes within the tolerances of it
+  // and of the records that were dropped before it
+  double anchorColumns[WTH_FLOAT_COLUMNS];
+  double endColumns[WTH_FLOAT_COLUMNS];
+  double columns[WTH_FLOAT_COLUMNS];
+  recordColumns(anchor, anchorColumns);
+  recordColumns(end, endColumns);
+  recordColumns(record, columns);
+  double endSeconds = endTime - anchorTime;
+  double seconds = time - anchorTime;
+  bool fits = end.Rn == anchor.Rn && end.Sn == anchor.Sn && record.Rn == anchor.Rn && record.Sn == anchor.Sn;
+  for (int column = 0; column < WTH_FLOAT_COLUMNS; ++column)
+  {
+    slopeLow[column] = std::max(slopeLow[column],
+      (endColumns[column] - tolerances[column] - anchorColumns[column]) / endSeconds);
+    slopeHigh[column] = std::min(slopeHigh[column],
+      (endColumns[column] + tolerances[column] - anchorColumns[column]) / endSeconds);
+    double slope = (columns[column] - anchorColumns[column]) / seconds;
+    fits = fits && slope >= slopeLow[column] && slope <= slopeHigh[column];
+  }
+  if (!fits)
+  {
+    // keep the end record and start the next line from it
+    writeLine(end, endTime);
+    anchor = end;
+    anchorTime = endTime;
+    resetSlopes();
+  }
+  end = record;
+  endTime = time;
+}
+
+// format the line of a record
+// record - the record to write
+// time - the time to write for the record in seconds of the day
+void wthWriter::writeLine(const wthRecordStruct &record, int time)
+{
+  if (stats)
+  {
+    ++stats->rowsWritten;
+  }
+  appendText(dateLabel(record.date));
+  appendText("\t");
+  std::string_view label = timeLabel(time);
+  if (label.empty())
+  {
+    // the table only holds whole minutes
+    appendText(IntTimeToStringTime(time));
+  }
+  else
+  {
+    appendText(label);
+  }
+  reserve(10 * (MAX_NUMBER_LENGTH + 1));
+  const float values[8] = { record.Ta, record.Pb, record.Ws, record.Wd, record.Hr,
+    record.Ith, record.Idn, record.Ts };
+  for (int index = 0; index < 8; ++index)
+  {
+    buffer[used++] = '\t';
+    writeFloat(values[index]);
+  }
+  buffer[used++] = '\t';
+  writeInt(record.Rn);
+  buffer[used++] = '\t';
+  writeInt(record.Sn);
+  buffer[used++] = '\n';
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "EPWConverter.h"
+#include "conversionStats.h"
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// the number of float columns of a record, the tolerances of compress() are in this order:
+// Ta [K], Pb [Pa], Ws [m/s], Wd [deg], Hr [g/kg], Ith [kJ/m^2], Idn [kJ/m^2], Ts [K]
+const int WTH_FLOAT_COLUMNS = 8;
+
+// formats the lines of a CONTAM weather file into a large buffer
+// and writes the buffer to the output stream in blocks
+// nothing is flushed until the buffer is full or flush() is called
+class wthWriter
+{
+public:
+  explicit wthWriter(std::ostream *ostream, int precision = -1, size_t blockSize = 64 * 1024);
+  ~wthWriter();
+
+  wthWriter(const wthWriter &) = delete;
+  wthWriter &operator=(const wthWriter &) = delete;
+
+  void writeText(std::string_view text);
+  void writeDay(int date, int dayOfWeek, int dayType, int daylightSavings);
+  void writeRecord(const wthRecordStruct &record, int time);
+  void writeFirstRecord(const wthRecordStruct &record);
+  void flush();
+  std::string takeOutput();
+  std::string_view output() const;
+  void measure(conversionStatsStruct *stats);
+  void compress(const float *tolerances);
+
+private:
+  void reserve(size_t length);
+  void writeBlock();
+  void appendText(std::string_view text);
+  void writeLine(const wthRecordStruct &record, int time);
+  void resetSlopes();
+  void finishRecords();
+  void writeFloat(float value);
+  void writeInt(int value);
+
+  std::ostream *ostream; // where the blocks are written (NULL to keep the output in memory)
+  int precision;         // the number of decimals for the floats (-1 = the same as a default stream)
+  size_t blockSize;      // the size of the blocks that are written to the stream
+  std::string buffer;    // the formatted text that has not been written yet
+  size_t used;           // the number of bytes of the buffer that are in use
+  conversionStatsStruct *stats; // receives the bytes written to the stream and the time it took (NULL = not measured)
+
+  // the records that are dropped by compress() (see writeRecord)
+  bool compressing;                     // true if records are dropped
+  float tolerances[WTH_FLOAT_COLUMNS];  // how far a dropped value can be from the line between the kept records
+  bool hasAnchor;                       // true once a record has been kept
+  wthRecordStruct anchor;               // the last record that was kept
+  int anchorTime;                       // the time that the anchor was written with
+  bool hasEnd;                          // true if there is a record after the anchor that is waiting
+  wthRecordStruct end;                  // the latest record, it is kept if the next one can't replace it
+  int endTime;                          // the time of the end record
+  double slopeLow[WTH_FLOAT_COLUMNS];   // the lowest slope from the anchor that passes the dropped records
+  double slopeHigh[WTH_FLOAT_COLUMNS];  // the highest slope from the anchor that passes the dropped records
+};
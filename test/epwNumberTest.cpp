@@ -0,0 +1,268 @@
+#include "../bench/epwGenerator.h"
+#include "../src/epwNumber.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// checks parseEPWFloat and parseEPWInt against std::stof and std::stoi
+// a field has to give the same bits as std::stof and the same integer as std::stoi, and it has to fail
+// where they throw
+//
+// the fields are:
+//   the fields of the data rows of a synthetic epw file and of any epw files that are given
+//   every decimal with 1 to 7 digits with the point at each position, both signs
+//   the decimals around 2^24 (the limit of the fast path) with the point at each position
+//   fields that aren't in the usual format or are out of range (signs, spaces, exponents, inf, nan ...)
+//   random strings of digits, points, signs, exponents, spaces and letters
+//
+// build on Linux from the root of the repository with make, which writes build/epwNumberTest
+// make test builds and runs it
+//
+// epwNumberTest [--quick] [<EPW File> ...]
+//   --quick checks the decimals with up to 6 digits and fewer random strings
+//   exits with 1 if any field is read differently and 0 if they are all the same
+
+// the number of mismatches that are printed
+const long long PRINTED_MISMATCHES = 20;
+
+// the counts of the fields that have been checked
+struct numberTestStruct
+{
+  long long checked = 0;
+  long long mismatches = 0;
+};
+
+// check a field with parseEPWFloat against std::stof
+static void checkFloat(const std::string &field, numberTestStruct &test)
+{
+  float expected = 0.0f;
+  int expectedResult = 0;
+  try
+  {
+    expected = std::stof(field);
+  }
+  catch (...)
+  {
+    expectedResult = -1;
+  }
+  float value = 0.0f;
+  int result = parseEPWFloat(field, value);
+  ++test.checked;
+  if (result != expectedResult || (result == 0 && memcmp(&value, &expected, sizeof(float)) != 0))
+  {
+    if (++test.mismatches <= PRINTED_MISMATCHES)
+    {
+      printf("parseEPWFloat(\"%s\") gives %d %.9g, std::stof gives %d %.9g\n", field.c_str(), result, value,
+        expectedResult, expected);
+    }
+  }
+}
+
+// check a field with parseEPWInt against std::stoi
+static void checkInt(const std::string &field, numberTestStruct &test)
+{
+  int expected = 0;
+  int expectedResult = 0;
+  try
+  {
+    expected = std::stoi(field);
+  }
+  catch (...)
+  {
+    expectedResult = -1;
+  }
+  int value = 0;
+  int result = parseEPWInt(field, value);
+  ++test.checked;
+  if (result != expectedResult || (result == 0 && value != expected))
+  {
+    if (++test.mismatches <= PRINTED_MISMATCHES)
+    {
+      printf("parseEPWInt(\"%s\") gives %d %d, std::stoi gives %d %d\n", field.c_str(), result, value,
+        expectedResult, expected);
+    }
+  }
+}
+
+// check every field of the data rows of the text of an epw file as both a float and an integer
+static void checkEPWText(const std::string &epwText, numberTestStruct &test)
+{
+  size_t lineStart = 0;
+  int lineNumber = 0;
+  while (lineStart < epwText.length())
+  {
+    size_t lineEnd = epwText.find('\n', lineStart);
+    if (lineEnd == std::string::npos)
+    {
+      lineEnd = epwText.length();
+    }
+    // the first 8 lines are the header
+    if (++lineNumber > 8)
+    {
+      size_t fieldStart = lineStart;
+      while (true)
+      {
+        size_t comma = epwText.find(',', fieldStart);
+        size_t fieldEnd = comma == std::string::npos || comma > lineEnd ? lineEnd : comma;
+        std::string field = epwText.substr(fieldStart, fieldEnd - fieldStart);
+        checkFloat(field, test);
+        checkInt(field, test);
+        if (fieldEnd == lineEnd)
+        {
+          break;
+        }
+        fieldStart = fieldEnd + 1;
+      }
+    }
+    lineStart = lineEnd + 1;
+  }
+}
+
+// check every decimal with digitCount digits with the point at each position and both signs
+// an integer (the point at the end) is also checked without the point and as an integer
+static void checkDecimals(int digitCount, numberTestStruct &test)
+{
+  int limit = 1;
+  for (int digit = 0; digit < digitCount; ++digit)
+  {
+    limit *= 10;
+  }
+  char digits[16];
+  char field[32];
+  for (int number = 0; number < limit; ++number)
+  {
+    snprintf(digits, sizeof(digits), "%0*d", digitCount, number);
+    for (int point = 0; point <= digitCount; ++point)
+    {
+      for (int negative = 0; negative < 2; ++negative)
+      {
+        int length = 0;
+        if (negative)
+        {
+          field[length++] = '-';
+        }
+        memcpy(field + length, digits, point);
+        length += point;
+        if (point < digitCount)
+        {
+          field[length++] = '.';
+        }
+        memcpy(field + length, digits + point, digitCount - point);
+        length += digitCount - point;
+        field[length] = '\0';
+        checkFloat(field, test);
+        if (point == digitCount)
+        {
+          checkInt(field, test);
+          // a point with no decimals after it, e.g. "12."
+          field[length++] = '.';
+          field[length] = '\0';
+          checkFloat(field, test);
+        }
+      }
+    }
+  }
+}
+
+// check the decimals around 2^24, the largest digits that the fast path reads
+// below it the fast path reads them, above it they go to strtof
+static void checkFastPathLimit(numberTestStruct &test)
+{
+  for (long long number = 16777000; number < 16778000; ++number)
+  {
+    for (size_t point = 0; point <= 8; ++point)
+    {
+      std::string field = std::to_string(number);
+      field.insert(point, ".");
+      checkFloat(field, test);
+      checkFloat("-" + field, test);
+    }
+  }
+}
+
+// check the fields that aren't in the usual format, are out of range or aren't numbers at all
+static void checkSpecialFields(numberTestStruct &test)
+{
+  const char *const fields[] = { "", "-", ".", "-.", "+1", " 1", "1 ", "1e5", "1E-3", "inf", "-nan", "0x1p3",
+    "1.5abc", "12abc", "999999999", "1234567890", "99999999999", "3.4028236e38", "1e-50", "1e39", "-0",
+    "-0.0", "0.000000001", "0.0000000001", "2147483647", "2147483648", "-2147483648", "-2147483649",
+    "00000000012.5", "\r", "1\r", "9.", ".9", "--1", "1..2", "1.2.3", "9999", "99999", "999999999.9",
+    "123456789012345678901234567890123456789012345678901234567890123456789.5" };
+  for (const char *field : fields)
+  {
+    checkFloat(field, test);
+    checkInt(field, test);
+  }
+}
+
+// check random strings of the characters that are found around numbers
+static void checkRandomFields(int count, numberTestStruct &test)
+{
+  std::mt19937 generator(1);
+  const char characters[] = "0123456789.-+eE xa";
+  const size_t characterCount = sizeof(characters) - 1;
+  for (int index = 0; index < count; ++index)
+  {
+    size_t length = generator() % 14;
+    std::string field;
+    for (size_t character = 0; character < length; ++character)
+    {
+      field += characters[generator() % characterCount];
+    }
+    checkFloat(field, test);
+    checkInt(field, test);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  bool quick = false;
+  std::vector<std::string> epwPaths;
+  for (int index = 1; index < argc; ++index)
+  {
+    if (strcmp(argv[index], "--quick") == 0)
+    {
+      quick = true;
+    }
+    else
+    {
+      epwPaths.push_back(argv[index]);
+    }
+  }
+
+  numberTestStruct test;
+  checkEPWText(generateEPW({ 60, 1, 1 }), test);
+  for (const std::string &epwPath : epwPaths)
+  {
+    std::ifstream epwFile(epwPath, std::ios::binary);
+    if (!epwFile)
+    {
+      printf("could not open %s\n", epwPath.c_str());
+      return 1;
+    }
+    std::string epwText((std::istreambuf_iterator<char>(epwFile)), std::istreambuf_iterator<char>());
+    checkEPWText(epwText, test);
+  }
+  printf("epw fields:     %lld checked\n", test.checked);
+
+  long long checked = test.checked;
+  for (int digitCount = 1; digitCount <= (quick ? 6 : 7); ++digitCount)
+  {
+    checkDecimals(digitCount, test);
+  }
+  printf("decimals:       %lld checked\n", test.checked - checked);
+
+  checked = test.checked;
+  checkFastPathLimit(test);
+  checkSpecialFields(test);
+  checkRandomFields(quick ? 200000 : 5000000, test);
+  printf("other fields:   %lld checked\n", test.checked - checked);
+
+  printf("%lld checked, %lld different\n", test.checked, test.mismatches);
+  return test.mismatches == 0 ? 0 : 1;
+}
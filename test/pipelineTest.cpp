@@ -0,0 +1,125 @@
+#include "../bench/epwGenerator.h"
+#include "../src/config.h"
+#include "../src/conversionPipeline.h"
+#include "../src/EPWConverter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// a stress test of the pipelined conversion (--pipeline -j 32)
+// a synthetic 10-minute epw file with more blocks than the ring has slots is converted again and again
+// with 32 workers, far more threads than most processors have so the stages are often preempted
+// each weather file has to be the same as the one from convertEPW and each conversion has to finish,
+// a conversion that makes no progress for PIPELINE_TIMEOUT_SECONDS is taken to be a hang
+//
+// build on Linux from the root of the repository with make, which writes build/pipelineTest
+// make test builds and runs it
+//
+// pipelineTest [--iterations <Count>] [--threads <Count>]
+//   --iterations is the number of conversions (default 40)
+//   --threads is the number of workers (default 32)
+//   exits with 1 if a weather file is different or a conversion hangs and 0 otherwise
+
+// the seconds that a conversion can take before the test fails
+const int PIPELINE_TIMEOUT_SECONDS = 120;
+
+// the config of a conversion with the default options
+static configStruct defaultConfig()
+{
+  configStruct config;
+  config.useDST = 0;
+  config.startDate = -1;
+  config.endDate = -1;
+  config.firstDOY = 1;
+  config.validConfig = 1;
+  return config;
+}
+
+// the number of conversions that have finished, the watchdog fails the test if it stops changing
+static std::atomic<int> finishedCount(0);
+
+// fail the test if no conversion finishes for PIPELINE_TIMEOUT_SECONDS
+static void watchdog()
+{
+  int lastCount = -1;
+  auto lastChange = std::chrono::steady_clock::now();
+  while (true)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int count = finishedCount.load();
+    auto now = std::chrono::steady_clock::now();
+    if (count != lastCount)
+    {
+      lastCount = count;
+      lastChange = now;
+    }
+    else if (now - lastChange > std::chrono::seconds(PIPELINE_TIMEOUT_SECONDS))
+    {
+      printf("conversion %d has not finished after %d seconds\n", count + 1, PIPELINE_TIMEOUT_SECONDS);
+      fflush(stdout);
+      std::_Exit(1);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int iterations = 40;
+  int threads = 32;
+  for (int index = 1; index < argc; ++index)
+  {
+    if (strcmp(argv[index], "--iterations") == 0 && index + 1 < argc)
+    {
+      iterations = atoi(argv[++index]);
+    }
+    else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+    {
+      threads = atoi(argv[++index]);
+    }
+    else
+    {
+      printf("usage: pipelineTest [--iterations <Count>] [--threads <Count>]\n");
+      return 1;
+    }
+  }
+
+  // 3 years of 10-minute records is about 100 blocks, more than the 2 * 32 + 2 slots of the ring
+  std::string epw = generateEPW({ 10, 3, 1 });
+  configStruct config = defaultConfig();
+  std::ostringstream expected;
+  if (convertEPW(config, epw.data(), epw.data() + epw.length(), expected) != 0)
+  {
+    printf("convertEPW failed\n");
+    return 1;
+  }
+
+  std::thread(watchdog).detach();
+  config.pipeline = true;
+  config.dataThreads = threads;
+  int failures = 0;
+  for (int iteration = 0; iteration < iterations; ++iteration)
+  {
+    std::istringstream istream(epw);
+    std::ostringstream ostream;
+    conversionErrorStruct error;
+    if (convertEPWPipelined(config, istream, ostream, error) != 0)
+    {
+      printf("conversion %d failed: %s\n", iteration + 1, error.errMsg.c_str());
+      ++failures;
+    }
+    else if (ostream.str() != expected.str())
+    {
+      printf("conversion %d is different from convertEPW\n", iteration + 1);
+      ++failures;
+    }
+    finishedCount.store(iteration + 1);
+  }
+  printf("%d conversions with %d workers, %d failed\n", iterations, threads, failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include "../src/psychrometrics.h"
+#include "../src/utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// checks every version of psychrometricsBatch that the processor supports (AVX2, SSE2 and the scalar
+// fallback) against 1000 * psywdp(Td, Pb) and skyTf(Ta, Td, tcc) over the range of the epw fields
+// the results have to be the same bits as the scalar functions give, there is no ulp tolerance
+//
+// the inputs are a grid of every dew point with one decimal from -70 C to 70 C, every tenth of cloud
+// cover and the pressures from 31000 Pa to 120000 Pa in steps of 100 Pa, then random values in the same
+// ranges, they are passed to the batch functions in batches of 1 to 37 records so that the tails and
+// the unaligned loads are covered as well
+//
+// build on Linux from the root of the repository with make, which writes build/psychrometricsTest
+// make test builds and runs it
+//
+// psychrometricsTest
+//   exits with 1 if any result is different and 0 if they are all the same
+
+// the longest batch that the records are passed in
+const size_t LONGEST_BATCH = 37;
+
+// the number of random records after the grid
+const size_t RANDOM_RECORD_COUNT = 4000000;
+
+// the inputs of a set of records
+struct psychrometricsInputStruct
+{
+  std::vector<float> dryBulbK;
+  std::vector<float> dewPointK;
+  std::vector<float> pressure;
+  std::vector<float> tenthsCloudCover;
+};
+
+// add a record to the inputs
+static void addRecord(psychrometricsInputStruct &inputs, float dryBulb, float dewPoint, float pressure,
+  float tenthsCloudCover)
+{
+  inputs.dryBulbK.push_back(dryBulb + 273.15f);
+  inputs.dewPointK.push_back(dewPoint + 273.15f);
+  inputs.pressure.push_back(pressure);
+  inputs.tenthsCloudCover.push_back(tenthsCloudCover);
+}
+
+// the grid of dew points, cloud covers and pressures
+// the dry bulb is stepped through the temperatures at or above the dew point
+static void makeGrid(psychrometricsInputStruct &inputs)
+{
+  int step = 0;
+  for (int dewPoint = -700; dewPoint <= 700; ++dewPoint)
+  {
+    for (int tenths = 0; tenths <= 10; ++tenths)
+    {
+      for (int pressure = 31000; pressure <= 120000; pressure += 100)
+      {
+        int dryBulb = dewPoint + step % (701 - dewPoint);
+        addRecord(inputs, dryBulb / 10.0f, dewPoint / 10.0f, (float)pressure, (float)tenths);
+        step += 7;
+      }
+    }
+  }
+}
+
+// random records in the same ranges as the grid, not rounded to the decimals of an epw file
+static void makeRandom(psychrometricsInputStruct &inputs, size_t count)
+{
+  std::mt19937 generator(20240601);
+  std::uniform_real_distribution<float> temperature(-70.0f, 70.0f);
+  std::uniform_real_distribution<float> pressure(31000.0f, 120000.0f);
+  std::uniform_real_distribution<float> cloudCover(0.0f, 10.0f);
+  for (size_t index = 0; index < count; ++index)
+  {
+    float first = temperature(generator);
+    float second = temperature(generator);
+    float dryBulb = first > second ? first : second;
+    float dewPoint = first > second ? second : first;
+    addRecord(inputs, dryBulb, dewPoint, pressure(generator), cloudCover(generator));
+  }
+}
+
+// run one version over the inputs and compare it with the scalar functions
+// return the number of results that are different
+static size_t checkVersion(const psychrometricsBatchVersionStruct &version,
+  const psychrometricsInputStruct &inputs)
+{
+  size_t count = inputs.dryBulbK.size();
+  std::vector<float> humidityRatio(count);
+  std::vector<float> skyTemperature(count);
+  size_t batchLength = 1;
+  for (size_t index = 0; index < count; index += batchLength)
+  {
+    batchLength = batchLength % LONGEST_BATCH + 1;
+    size_t length = count - index < batchLength ? count - index : batchLength;
+    version.function(&inputs.dryBulbK[index], &inputs.dewPointK[index], &inputs.pressure[index],
+      &inputs.tenthsCloudCover[index], &humidityRatio[index], &skyTemperature[index], length);
+  }
+
+  size_t mismatches = 0;
+  for (size_t index = 0; index < count; ++index)
+  {
+    float expectedHumidityRatio = 1000.0f * psywdp(inputs.dewPointK[index], inputs.pressure[index]);
+    float expectedSkyTemperature =
+      skyTf(inputs.dryBulbK[index], inputs.dewPointK[index], inputs.tenthsCloudCover[index]);
+    if (memcmp(&humidityRatio[index], &expectedHumidityRatio, sizeof(float)) != 0 ||
+      memcmp(&skyTemperature[index], &expectedSkyTemperature, sizeof(float)) != 0)
+    {
+      if (mismatches < 10)
+      {
+        printf("%s: Ta=%.9g Td=%.9g Pb=%.9g tcc=%.9g gives W=%.9g Ts=%.9g, expected W=%.9g Ts=%.9g\n",
+          version.name, inputs.dryBulbK[index], inputs.dewPointK[index], inputs.pressure[index],
+          inputs.tenthsCloudCover[index], humidityRatio[index], skyTemperature[index], expectedHumidityRatio,
+          expectedSkyTemperature);
+      }
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+int main()
+{
+  psychrometricsInputStruct inputs;
+  makeGrid(inputs);
+  makeRandom(inputs, RANDOM_RECORD_COUNT);
+
+  std::vector<psychrometricsBatchVersionStruct> versions;
+  psychrometricsBatchVersions(versions);
+  size_t totalMismatches = 0;
+  for (const psychrometricsBatchVersionStruct &version : versions)
+  {
+    size_t mismatches = checkVersion(version, inputs);
+    printf("%-6s %zu records, %zu different\n", version.name, inputs.dryBulbK.size(), mismatches);
+    totalMismatches += mismatches;
+  }
+  if (versions.size() < 3)
+  {
+    printf("the versions that aren't listed are not supported by this processor or compiler\n");
+  }
+  return totalMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// compares the scalar web build with the WASM SIMD and pthreads build on Node (no browser needed)
+// each build is loaded in a process of its own and converts the epw file with ConvertEPWData,
+// the fastest of the runs is reported and the weather files of the two builds are checked to be the same
+//
+// node benchmark.js <epw file> [<runs>]
+//   run it from the directory with CONTAM_EPWtoWeatherFile.js and CONTAM_EPWtoWeatherFile_simd.js
+//   the pthreads build needs Node 21 or later (for navigator.hardwareConcurrency)
+//   epwBenchmark --generate <Directory> writes synthetic epw files that are large enough to time
+
+var childProcess = require('child_process');
+var crypto = require('crypto');
+var fs = require('fs');
+var path = require('path');
+
+var BUILDS = [
+  { name: 'scalar', script: 'CONTAM_EPWtoWeatherFile.js' },
+  { name: 'simd+pthreads', script: 'CONTAM_EPWtoWeatherFile_simd.js' }
+];
+
+// convert the epw file with one build and print the result as JSON
+function runBuild(script, epwPath, runs)
+{
+  var Module = require(path.resolve(script));
+  var run = function ()
+  {
+    var epw = fs.readFileSync(epwPath);
+    var epwData = Module._AllocateEPW(epw.length);
+    Module.HEAPU8.set(epw, epwData);
+    var best = Infinity;
+    for (var i = 0; i < runs; ++i)
+    {
+      var start = process.hrtime.bigint();
+      if (Module._ConvertEPWData(epwData, epw.length, 0) !== 0)
+      {
+        console.log(JSON.stringify({ error: Module.UTF8ToString(Module._GetConversionError()) }));
+        process.exit(1);
+      }
+      best = Math.min(best, Number(process.hrtime.bigint() - start) / 1e6);
+    }
+    Module._FreeEPW(epwData);
+    var wthData = Module._GetWTHData();
+    var wth = Module.HEAPU8.subarray(wthData, wthData + Module._GetWTHSize());
+    var hash = crypto.createHash('sha256').update(wth).digest('hex');
+    console.log(JSON.stringify({ milliseconds: best, epwSize: epw.length, wthSize: wth.length, hash: hash }));
+    // the main loop of the module keeps Node running
+    process.exit(0);
+  };
+  if (Module.calledRun)
+  {
+    run();
+  }
+  else
+  {
+    Module.onRuntimeInitialized = run;
+  }
+}
+
+function main()
+{
+  var args = process.argv.slice(2);
+  if (args[0] === '--build')
+  {
+    runBuild(args[1], args[2], parseInt(args[3], 10));
+    return;
+  }
+  if (args.length < 1)
+  {
+    console.error('Usage: node benchmark.js <epw file> [<runs>]');
+    process.exit(1);
+  }
+  var epwPath = args[0];
+  var runs = args.length > 1 ? parseInt(args[1], 10) : 5;
+
+  var results = [];
+  BUILDS.forEach(function (build)
+  {
+    if (!fs.existsSync(build.script))
+    {
+      console.error('Skipping ' + build.name + ', ' + build.script + ' was not found.');
+      return;
+    }
+    var child = childProcess.spawnSync(process.execPath, [__filename, '--build', build.script, epwPath, runs],
+      { encoding: 'utf8' });
+    var lines = (child.stdout || '').trim().split('\n');
+    var result = null;
+    try
+    {
+      result = JSON.parse(lines[lines.length - 1]);
+    }
+    catch (e)
+    {
+    }
+    if (result === null || result.error)
+    {
+      console.error(build.name + ' failed: ' + (result ? result.error : child.stderr));
+      return;
+    }
+    result.name = build.name;
+    results.push(result);
+  });
+
+  if (results.length === 0)
+  {
+    process.exit(1);
+  }
+  results.forEach(function (result)
+  {
+    console.log(result.name.padEnd(16) + result.milliseconds.toFixed(1).padStart(10) + ' ms' +
+      (result.epwSize / result.milliseconds / 1e3).toFixed(1).padStart(10) + ' MB/s' +
+      (results[0].milliseconds / result.milliseconds).toFixed(2).padStart(8) + 'x');
+  });
+  if (results.length === 2 && results[0].hash !== results[1].hash)
+  {
+    console.error('The weather files of the builds are not the same.');
+    process.exit(1);
+  }
+}
+
+main();
@@ -0,0 +1,143 @@
+// a Web Worker that converts epw files with the Emscripten build without blocking the page
+// the conversion is done a number of rows at a time and the worker returns to its event loop
+// between the steps so the page can cancel it
+//
+// the page sends:
+//   { type: 'convert', epw: ArrayBuffer, config: string, rowsPerStep: number }
+//     config is the contents of a config file (JSON) or '' for the default config
+//     rowsPerStep is optional
+//   { type: 'cancel' }
+// the worker sends:
+//   { type: 'ready', build: string } once the module has loaded, build is the script that was loaded
+//   { type: 'progress', rowsDone: number, rowCount: number } after each step
+//   { type: 'done', wth: ArrayBuffer } with the weather file (transferred, not copied)
+//   { type: 'error', message: string }
+//   { type: 'cancelled' }
+//
+// usage from the page:
+//   var worker = new Worker('epwWorker.js');
+//   worker.postMessage({ type: 'convert', epw: epwBuffer, config: '' }, [epwBuffer]);
+
+// the conversion that is running, null when there is none
+var conversion = null;
+
+// the build with WASM SIMD and pthreads converts the data on several threads
+// it needs a browser with WASM SIMD and a page that is cross-origin isolated so it can share memory
+// (served with Cross-Origin-Opener-Policy: same-origin and Cross-Origin-Embedder-Policy: require-corp)
+// otherwise the scalar build is used
+var SIMD_BUILD = 'CONTAM_EPWtoWeatherFile_simd.js';
+var SCALAR_BUILD = 'CONTAM_EPWtoWeatherFile.js';
+
+// a module with a function that uses a SIMD instruction, it only validates if the browser has WASM SIMD
+var SIMD_TEST = new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0,
+  65, 0, 253, 15, 253, 98, 11]);
+
+function canUseSIMDBuild()
+{
+  try
+  {
+    return self.crossOriginIsolated === true && WebAssembly.validate(SIMD_TEST);
+  }
+  catch (e)
+  {
+    return false;
+  }
+}
+
+var build = canUseSIMDBuild() ? SIMD_BUILD : SCALAR_BUILD;
+
+// the number of rows of data converted before the worker checks for messages
+// the SIMD build shares each step between its threads so it takes larger steps
+var DEFAULT_ROWS_PER_STEP = build === SIMD_BUILD ? 20000 : 2000;
+
+var Module = {
+  // the pthreads of the SIMD build load the same script as the worker did
+  mainScriptUrlOrBlob: build,
+  onRuntimeInitialized: function ()
+  {
+    postMessage({ type: 'ready', build: build });
+  },
+  onConversionProgress: function (rowsDone, rowCount)
+  {
+    postMessage({ type: 'progress', rowsDone: rowsDone, rowCount: rowCount });
+  }
+};
+
+importScripts(build);
+
+// release the epw file of the conversion in the WASM memory
+function endConversion()
+{
+  if (conversion !== null)
+  {
+    Module._FreeEPW(conversion.epwData);
+    conversion = null;
+  }
+}
+
+function conversionError()
+{
+  return Module.UTF8ToString(Module._GetConversionError());
+}
+
+// convert the next rows and schedule the step after them
+function stepConversion()
+{
+  if (conversion === null)
+  {
+    return;
+  }
+  var retVal = Module._StepConversion(conversion.rowsPerStep);
+  if (retVal === 1)
+  {
+    // let the worker handle its messages before the next step
+    setTimeout(stepConversion, 0);
+    return;
+  }
+  endConversion();
+  if (retVal !== 0)
+  {
+    postMessage({ type: 'error', message: conversionError() });
+    return;
+  }
+  // copy the weather file out of the WASM memory, the view changes if the memory grows
+  var wthData = Module._GetWTHData();
+  var wth = Module.HEAPU8.slice(wthData, wthData + Module._GetWTHSize()).buffer;
+  Module._FreeWTH();
+  postMessage({ type: 'done', wth: wth }, [wth]);
+}
+
+onmessage = function (event)
+{
+  var message = event.data;
+  if (message.type === 'cancel')
+  {
+    if (conversion !== null)
+    {
+      Module._CancelConversion();
+      endConversion();
+      postMessage({ type: 'cancelled' });
+    }
+  }
+  else if (message.type === 'convert')
+  {
+    // a new conversion replaces the one that is running
+    if (conversion !== null)
+    {
+      Module._CancelConversion();
+      endConversion();
+    }
+    var epw = new Uint8Array(message.epw);
+    var epwData = Module._AllocateEPW(epw.length);
+    Module.HEAPU8.set(epw, epwData);
+    if (Module.ccall('StartConversion', 'number', ['number', 'number', 'string'],
+      [epwData, epw.length, message.config || '']) !== 0)
+    {
+      Module._FreeEPW(epwData);
+      postMessage({ type: 'error', message: conversionError() });
+      return;
+    }
+    conversion = { epwData: epwData, rowsPerStep: message.rowsPerStep || DEFAULT_ROWS_PER_STEP };
+    setTimeout(stepConversion, 0);
+  }
+};